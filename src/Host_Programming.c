@@ -124,6 +124,8 @@ Managing Device with contexts
 #include <stdlib.h>
 #include <string.h>
 
+#include "verify.h"
+
 #ifdef MAC
 #include <opencl-c-base.h>/cl.h>
 #else
@@ -207,7 +209,7 @@ void device_extension_test()
     printf("%s\n", "****************************************************");
     cl_platform_id platform;
     cl_device_id *devices;
-    cl_uint num_devices , addr_data;
+    cl_uint num_devices , addr_data , preferred_width , native_width;
     cl_int i , err;
     char name_data[48], ext_data[4096];
 
@@ -250,7 +252,12 @@ void device_extension_test()
         // Get Device extensions
         clGetDeviceInfo(devices[i] , CL_DEVICE_EXTENSIONS, sizeof(ext_data) , ext_data , NULL);
 
-        printf("Name: %s \n Address_width : %u \n Extensions: %s", name_data , addr_data , ext_data);
+        // Get float vector widths, used by vector_ops.c to pick the elementwise kernel variant
+        clGetDeviceInfo(devices[i] , CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &preferred_width , NULL);
+        clGetDeviceInfo(devices[i] , CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &native_width , NULL);
+
+        printf("Name: %s \n Address_width : %u \n Preferred_float_width : %u \n Native_float_width : %u \n Extensions: %s",
+               name_data , addr_data , preferred_width , native_width , ext_data);
     }
 
     free(devices);
@@ -679,21 +686,21 @@ void queue_kernel()
     exit(1);
     }
     // 9. Verify Results
-    int correct = 1;
+    /*
+        1. The device may round differently from the host (FMA contraction , flushed denormals), so the results are compared
+           with the ulp / relative tolerances from verify.h instead of ==.
+        2. The report prints the largest error and its index.
+    */
+    float expected[ARRAY_SIZE];
+    verify_report report;
     for(int i = 0 ; i < ARRAY_SIZE ; i++)
     {
-        float expected = A[i] + B[i];
-        
-        if(C[i] != expected)
-        {
-            correct = 0;
-            printf("Mismatch at index %d : Expected %f but got %f \n", i , expected , C[i]);
-            break;
-        }
+        expected[i] = A[i] + B[i];
     }
 
-    if(correct){printf("Results are correct! \n");}
+    if(verify_compare(NULL , expected , C , ARRAY_SIZE , VERIFY_DEFAULT_TOLERANCE , &report)){printf("Results are correct! \n");}
     else printf("Results are incorrect. \n");
+    verify_print("add_arrays" , &report);
 
     // 10 . clean up
     clReleaseMemObject(bufferA);
@@ -0,0 +1,230 @@
+/*
+
+Backend Parity Test
+-------------------
+
+1. Runs every kernel through the CPU backend and checks it against a plain C reference.
+2. When an OpenCL device is present, runs the same inputs through the OpenCL backend and checks it against the CPU backend.
+3. Elementwise ops and the blur must match exactly. mat_vec_mult sums in a different order, so it is compared with verify_compare tolerances,
+   and the gray conversion may round differently when the device contracts the weighted sum into FMAs , so it may differ by one level.
+   An OpenCL check also fails when the call fell back to the CPU , otherwise it would compare the CPU with itself.
+4. Sizes are odd on purpose so the SIMD tails and partial work-groups are exercised.
+5. Run once per instruction set with CPU_BACKEND_ISA=avx512 , avx2 and scalar. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 backend_test.c compute.c cpu_backend.c verify.c thread_pool.c specialize.c vector_ops.c kernel_cache.c perf_counters.c -o backend_test -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute.h"
+#include "verify.h"
+
+#define ARRAY_SIZE 1000003
+#define MAT_ROWS 517
+#define MAT_COLS 301
+#define IMAGE_WIDTH 641
+#define IMAGE_HEIGHT 479
+#define BLUR_SIZE 2
+
+static int failures = 0;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void report(const char *name , const char *backend , int ok)
+{
+    printf("%-14s %-8s %s\n", name , backend , ok ? "PASS" : "FAIL");
+    if(!ok)
+    {
+        failures++;
+    }
+}
+
+// compute.c falls back to the CPU on any OpenCL error , so an OpenCL check must also see that the device ran
+static int ran_on_opencl(const char *name , compute_backend backend)
+{
+    if(backend != BACKEND_OPENCL)
+    {
+        printf("%s fell back to the %s backend\n", name , compute_backend_name(backend));
+        return 0;
+    }
+    return 1;
+}
+
+static int within_one(const unsigned char *a , const unsigned char *b , size_t n)
+{
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        if(abs((int)a[i] - (int)b[i]) > 1)
+        {
+            printf("Mismatch at index %zu : %u vs %u\n", i , a[i] , b[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void reference_blur(const unsigned char *pIn , unsigned char *pOut , int width , int height , int radius)
+{
+    for(int row = 0 ; row < height ; row++)
+    {
+        for(int col = 0 ; col < width ; col++)
+        {
+            int sum[3] = {0 , 0 , 0};
+            int pixels = 0;
+            for(int blurRow = -radius ; blurRow <= radius ; blurRow++)
+            {
+                for(int blurCol = -radius ; blurCol <= radius ; blurCol++)
+                {
+                    int currRow = row + blurRow;
+                    int currCol = col + blurCol;
+                    if(currRow >= 0 && currRow < height && currCol >= 0 && currCol < width)
+                    {
+                        for(int c = 0 ; c < 3 ; c++)
+                        {
+                            sum[c] += pIn[(currRow * width + currCol) * 3 + c];
+                        }
+                        pixels++;
+                    }
+                }
+            }
+            for(int c = 0 ; c < 3 ; c++)
+            {
+                pOut[(row * width + col) * 3 + c] = sum[c] / pixels;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef compute_backend (*binary_entry)(compute_context* , compute_backend , const float* , const float* , float* , size_t);
+
+static void test_binary(compute_context *ctx , const char *name , binary_entry entry , char op ,
+                        const float *a , const float *b , float *expected , float *cpu , float *device)
+{
+    for(size_t i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        expected[i] = op == '*' ? a[i] * b[i] : op == '+' ? a[i] + b[i] : a[i] - b[i];
+    }
+
+    entry(ctx , BACKEND_CPU , a , b , cpu , ARRAY_SIZE);
+    report(name , "cpu" , memcmp(expected , cpu , ARRAY_SIZE * sizeof(float)) == 0);
+
+    if(ctx->has_opencl)
+    {
+        int ran = ran_on_opencl(name , entry(ctx , BACKEND_OPENCL , a , b , device , ARRAY_SIZE));
+        report(name , "opencl" , ran && memcmp(cpu , device , ARRAY_SIZE * sizeof(float)) == 0);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    compute_context ctx;
+    compute_init(&ctx);
+
+    printf("CPU backend instruction set: %s , %d threads\n", cpu_backend_isa() , thread_pool_size(ctx.pool));
+    printf("OpenCL backend: %s\n\n", ctx.has_opencl ? "available" : "not available");
+
+    // Elementwise
+    float *a = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *b = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *expected = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *cpu = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *device = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    for(size_t i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        a[i] = (float)rand() / RAND_MAX * 100.0f;
+        b[i] = (float)rand() / RAND_MAX * 100.0f - 50.0f;
+    }
+
+    test_binary(&ctx , "add_arrays" , compute_add_arrays , '+' , a , b , expected , cpu , device);
+    test_binary(&ctx , "mult" , compute_mult , '*' , a , b , expected , cpu , device);
+    test_binary(&ctx , "add" , compute_add , '+' , a , b , expected , cpu , device);
+    test_binary(&ctx , "sub" , compute_sub , '-' , a , b , expected , cpu , device);
+
+    // Matrix - vector
+    float *matrix = a;
+    float *vector = b;
+    for(size_t row = 0 ; row < MAT_ROWS ; row++)
+    {
+        double sum = 0.0;
+        for(size_t col = 0 ; col < MAT_COLS ; col++)
+        {
+            sum += (double)matrix[row * MAT_COLS + col] * vector[col];
+        }
+        expected[row] = (float)sum;
+    }
+
+    verify_tolerance tolerance = VERIFY_DEFAULT_TOLERANCE;
+    verify_report mat_vec_report;
+    tolerance.rel_tol = 1e-4f;
+    tolerance.abs_tol = 1e-3f;
+
+    compute_mat_vec_mult(&ctx , BACKEND_CPU , matrix , vector , cpu , MAT_ROWS , MAT_COLS);
+    report("mat_vec_mult" , "cpu" , verify_compare(ctx.pool , expected , cpu , MAT_ROWS , tolerance , &mat_vec_report));
+    if(ctx.has_opencl)
+    {
+        int ran = ran_on_opencl("mat_vec_mult" ,
+                                compute_mat_vec_mult(&ctx , BACKEND_OPENCL , matrix , vector , device , MAT_ROWS , MAT_COLS));
+        report("mat_vec_mult" , "opencl" , ran && verify_compare(ctx.pool , cpu , device , MAT_ROWS , tolerance , &mat_vec_report));
+    }
+
+    // Images
+    size_t num_pixels = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT;
+    unsigned char *image = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char *image_expected = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char *image_cpu = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char *image_device = (unsigned char*)malloc(num_pixels * 3);
+    for(size_t i = 0 ; i < num_pixels * 3 ; i++)
+    {
+        image[i] = (unsigned char)(rand() & 0xFF);
+    }
+
+    for(size_t i = 0 ; i < num_pixels ; i++)
+    {
+        image_expected[i] = (unsigned char)(0.299f * image[i * 3] + 0.587f * image[i * 3 + 1] + 0.114f * image[i * 3 + 2]);
+    }
+    compute_rgb_to_gray(&ctx , BACKEND_CPU , image_cpu , image , IMAGE_WIDTH , IMAGE_HEIGHT);
+    report("rgbToGrayScale" , "cpu" , within_one(image_expected , image_cpu , num_pixels));
+    if(ctx.has_opencl)
+    {
+        int ran = ran_on_opencl("rgbToGrayScale" ,
+                                compute_rgb_to_gray(&ctx , BACKEND_OPENCL , image_device , image , IMAGE_WIDTH , IMAGE_HEIGHT));
+        report("rgbToGrayScale" , "opencl" , ran && within_one(image_cpu , image_device , num_pixels));
+    }
+
+    reference_blur(image , image_expected , IMAGE_WIDTH , IMAGE_HEIGHT , BLUR_SIZE);
+    compute_blur(&ctx , BACKEND_CPU , image , image_cpu , IMAGE_WIDTH , IMAGE_HEIGHT , BLUR_SIZE);
+    report("blurKernel" , "cpu" , memcmp(image_expected , image_cpu , num_pixels * 3) == 0);
+    if(ctx.has_opencl)
+    {
+        int ran = ran_on_opencl("blurKernel" ,
+                                compute_blur(&ctx , BACKEND_OPENCL , image , image_device , IMAGE_WIDTH , IMAGE_HEIGHT , BLUR_SIZE));
+        report("blurKernel" , "opencl" , ran && memcmp(image_cpu , image_device , num_pixels * 3) == 0);
+    }
+
+    // Automatic selection: small problems stay on the host
+    printf("\nBACKEND_AUTO for 1024 elements ran on: %s\n",
+           compute_backend_name(compute_add_arrays(&ctx , BACKEND_AUTO , a , b , cpu , 1024)));
+    printf("BACKEND_AUTO for %d elements ran on: %s\n", ARRAY_SIZE ,
+           compute_backend_name(compute_add_arrays(&ctx , BACKEND_AUTO , a , b , cpu , ARRAY_SIZE)));
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    free(a);
+    free(b);
+    free(expected);
+    free(cpu);
+    free(device);
+    free(image);
+    free(image_expected);
+    free(image_cpu);
+    free(image_device);
+    compute_release(&ctx);
+
+    return failures;
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench_common.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void bench_init(bench_context *bench , int profiling)
+{
+    cl_int err;
+
+    err = clGetPlatformIDs(1 , &bench->platform , NULL);
+    if(err < 0)
+    {
+        perror("Couldn't find an OpenCL platform");
+        exit(1);
+    }
+
+    err = clGetDeviceIDs(bench->platform , CL_DEVICE_TYPE_GPU , 1 , &bench->device , NULL);
+    if(err < 0)
+    {
+        err = clGetDeviceIDs(bench->platform , CL_DEVICE_TYPE_ALL , 1 , &bench->device , NULL);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't find an OpenCL device");
+        exit(1);
+    }
+
+    bench->context = clCreateContext(NULL , 1 , &bench->device , NULL , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create a context");
+        exit(1);
+    }
+
+    cl_queue_properties props[] = {CL_QUEUE_PROPERTIES , CL_QUEUE_PROFILING_ENABLE , 0};
+    bench->queue = clCreateCommandQueueWithProperties(bench->context , bench->device , profiling ? props : NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create a command queue");
+        exit(1);
+    }
+
+    kernel_cache_init(&bench->cache , bench->context , bench->device);
+}
+
+void bench_release(bench_context *bench)
+{
+    kernel_cache_release(&bench->cache);
+    clReleaseCommandQueue(bench->queue);
+    clReleaseContext(bench->context);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+double bench_event_ms(cl_event event)
+{
+    cl_ulong start , end;
+    clWaitForEvents(1 , &event);
+    clGetEventProfilingInfo(event , CL_PROFILING_COMMAND_START , sizeof(start) , &start , NULL);
+    clGetEventProfilingInfo(event , CL_PROFILING_COMMAND_END , sizeof(end) , &end , NULL);
+    clReleaseEvent(event);
+    return (end - start) * 1.0e-6;
+}
+
+double bench_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC , &ts);
+    return ts.tv_sec * 1.0e3 + ts.tv_nsec * 1.0e-6;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_mem bench_buffer(cl_context context , size_t bytes , const void *data)
+{
+    cl_int err;
+    cl_mem buffer = clCreateBuffer(context , CL_MEM_READ_WRITE | (data != NULL ? CL_MEM_COPY_HOST_PTR : 0) , bytes , (void*)data , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create a buffer");
+        exit(1);
+    }
+    return buffer;
+}
@@ -0,0 +1,38 @@
+/*
+
+Benchmark Fixture
+-----------------
+
+1. Every bench and demo in this directory starts the same way: the first platform , a GPU (or any other device when there is
+   none) , a context , one in-order command queue and a kernel_cache. bench_init does it and exits on failure , bench_release
+   undoes it.
+2. profiling adds CL_QUEUE_PROFILING_ENABLE , which bench_event_ms needs. Benches that only time on the host leave it off.
+3. bench_event_ms waits for an event , returns its device time (COMMAND_START to COMMAND_END) and releases the event.
+4. bench_now_ms is a monotonic host clock for end to end times.
+
+*/
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "kernel_cache.h"
+
+typedef struct
+{
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue queue;
+    kernel_cache cache;
+} bench_context;
+
+void bench_init(bench_context *bench , int profiling);
+void bench_release(bench_context *bench);
+
+double bench_event_ms(cl_event event);
+double bench_now_ms(void);
+
+// Read-write buffer , initialized from data unless it is NULL. Exits on failure.
+cl_mem bench_buffer(cl_context context , size_t bytes , const void *data);
+
+#endif
@@ -0,0 +1,511 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_record.h"
+
+/*
+    1. The cl_khr_command_buffer entry points are not exported by the ICD loader, they are looked up with
+       clGetExtensionFunctionAddressForPlatform. The prototypes are declared here, so no cl_ext.h of a particular version is needed.
+    2. The signatures are those of version 0.9.5 and later, where clCommandCopyBufferKHR gained its properties argument.
+       Older provisional versions are not used.
+*/
+#ifndef CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR
+#define CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR 0x12A9
+#endif
+#ifndef CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR
+#define CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR (1 << 2)
+#endif
+#ifndef CL_COMMAND_BUFFER_FLAGS_KHR
+#define CL_COMMAND_BUFFER_FLAGS_KHR 0x1293
+#endif
+#ifndef CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR
+#define CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR (1 << 0)
+#endif
+
+#define COMMAND_BUFFER_EXTENSION "cl_khr_command_buffer"
+
+typedef cl_uint cmd_sync_point;
+
+typedef cmd_khr_buffer (CL_API_CALL *create_command_buffer_fn)(cl_uint num_queues , const cl_command_queue *queues ,
+                                                               const cl_properties *properties , cl_int *errcode_ret);
+typedef cl_int (CL_API_CALL *finalize_command_buffer_fn)(cmd_khr_buffer command_buffer);
+typedef cl_int (CL_API_CALL *release_command_buffer_fn)(cmd_khr_buffer command_buffer);
+typedef cl_int (CL_API_CALL *enqueue_command_buffer_fn)(cl_uint num_queues , cl_command_queue *queues , cmd_khr_buffer command_buffer ,
+                                                        cl_uint num_events , const cl_event *event_wait_list , cl_event *event);
+typedef cl_int (CL_API_CALL *command_ndrange_kernel_fn)(cmd_khr_buffer command_buffer , cl_command_queue command_queue ,
+                                                        const cl_properties *properties , cl_kernel kernel , cl_uint work_dim ,
+                                                        const size_t *global_work_offset , const size_t *global_work_size ,
+                                                        const size_t *local_work_size , cl_uint num_sync_points ,
+                                                        const cmd_sync_point *sync_point_wait_list , cmd_sync_point *sync_point ,
+                                                        void **mutable_handle);
+typedef cl_int (CL_API_CALL *command_copy_buffer_fn)(cmd_khr_buffer command_buffer , cl_command_queue command_queue ,
+                                                     const cl_properties *properties , cl_mem src_buffer , cl_mem dst_buffer ,
+                                                     size_t src_offset , size_t dst_offset , size_t size , cl_uint num_sync_points ,
+                                                     const cmd_sync_point *sync_point_wait_list , cmd_sync_point *sync_point ,
+                                                     void **mutable_handle);
+
+struct cmd_khr_api
+{
+    create_command_buffer_fn create;
+    finalize_command_buffer_fn finalize;
+    release_command_buffer_fn release;
+    enqueue_command_buffer_fn enqueue;
+    command_ndrange_kernel_fn ndrange_kernel;
+    command_copy_buffer_fn copy_buffer;
+    int simultaneous_use;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void cmd_record_init(cmd_recording *rec , cl_context context , cl_device_id device , cl_command_queue queue)
+{
+    memset(rec , 0 , sizeof(*rec));
+    rec->context = context;
+    rec->device = device;
+    rec->queue = queue;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cmd_entry* new_entry(cmd_recording *rec)
+{
+    if(rec->num_entries == rec->capacity)
+    {
+        rec->capacity = rec->capacity ? rec->capacity * 2 : 16;
+        rec->entries = (cmd_entry*)realloc(rec->entries , sizeof(cmd_entry) * rec->capacity);
+    }
+
+    cmd_entry *entry = &rec->entries[rec->num_entries++];
+    memset(entry , 0 , sizeof(*entry));
+    return entry;
+}
+
+static void release_entry(cmd_entry *entry)
+{
+    if(entry->owns_kernel)
+    {
+        clReleaseKernel(entry->kernel);
+    }
+    for(cl_uint a = 0 ; a < entry->num_args ; a++)
+    {
+        free(entry->arg_values[a]);
+    }
+}
+
+static void use_slot(cmd_recording *rec , int slot)
+{
+    if(slot + 1 > rec->num_slots)
+    {
+        rec->num_slots = slot + 1;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int cmd_record_kernel(cmd_recording *rec , cl_kernel kernel , cl_uint work_dim , const size_t *global_size , const size_t *local_size ,
+                         cl_uint num_args , const cmd_arg *args)
+{
+    cl_int err;
+
+    if(num_args > CMD_RECORD_MAX_ARGS || work_dim < 1 || work_dim > 3)
+    {
+        return CL_INVALID_VALUE;
+    }
+    for(cl_uint i = 0 ; i < num_args ; i++)
+    {
+        if(args[i].slot >= CMD_RECORD_MAX_SLOTS)
+        {
+            return CL_INVALID_VALUE;
+        }
+    }
+
+    // Built here and appended only once every argument is set , so a failed call leaves the recording unchanged
+    cmd_entry entry;
+    memset(&entry , 0 , sizeof(entry));
+    entry.type = CMD_KERNEL;
+    entry.work_dim = work_dim;
+    entry.has_local_size = local_size != NULL;
+    entry.num_args = num_args;
+
+    for(cl_uint d = 0 ; d < work_dim ; d++)
+    {
+        entry.global_size[d] = global_size[d];
+        entry.local_size[d] = local_size ? local_size[d] : 0;
+    }
+
+    // A private clone keeps this launch's arguments bound between replays. Cloning needs OpenCL 2.1.
+    // Otherwise the caller's kernel is retained , so the recording stays valid if the caller releases it first.
+    entry.kernel = clCloneKernel(kernel , &err);
+    entry.is_clone = (err == CL_SUCCESS);
+    if(!entry.is_clone)
+    {
+        entry.kernel = kernel;
+        clRetainKernel(kernel);
+    }
+    entry.owns_kernel = 1;
+
+    for(cl_uint i = 0 ; i < num_args ; i++)
+    {
+        entry.arg_slots[i] = args[i].slot;
+        entry.arg_sizes[i] = args[i].size;
+        entry.bound[i] = NULL;
+
+        if(args[i].slot < 0 && args[i].value != NULL)
+        {
+            entry.arg_values[i] = (unsigned char*)malloc(args[i].size);
+            memcpy(entry.arg_values[i] , args[i].value , args[i].size);
+        }
+
+        if(args[i].slot < 0 && entry.is_clone)
+        {
+            err = clSetKernelArg(entry.kernel , i , args[i].size , args[i].value);
+            if(err != CL_SUCCESS)
+            {
+                release_entry(&entry);
+                return err;
+            }
+        }
+    }
+
+    for(cl_uint i = 0 ; i < num_args ; i++)
+    {
+        if(args[i].slot >= 0)
+        {
+            use_slot(rec , args[i].slot);
+        }
+    }
+    *new_entry(rec) = entry;
+
+    return CL_SUCCESS;
+}
+
+cl_int cmd_record_copy(cmd_recording *rec , int src_slot , int dst_slot , size_t src_offset , size_t dst_offset , size_t size)
+{
+    if(src_slot < 0 || dst_slot < 0 || src_slot >= CMD_RECORD_MAX_SLOTS || dst_slot >= CMD_RECORD_MAX_SLOTS)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cmd_entry *entry = new_entry(rec);
+    entry->type = CMD_COPY;
+    entry->src_slot = src_slot;
+    entry->dst_slot = dst_slot;
+    entry->src_offset = src_offset;
+    entry->dst_offset = dst_offset;
+    entry->size = size;
+    use_slot(rec , src_slot);
+    use_slot(rec , dst_slot);
+
+    return CL_SUCCESS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int has_command_buffer_extension(cl_device_id device)
+{
+    size_t size = 0;
+    int found = 0;
+
+    // CL_DEVICE_EXTENSIONS_WITH_VERSION is an OpenCL 3.0 query. Without it the extension version is unknown, so it isn't used.
+    if(clGetDeviceInfo(device , CL_DEVICE_EXTENSIONS_WITH_VERSION , 0 , NULL , &size) != CL_SUCCESS || size == 0)
+    {
+        return 0;
+    }
+
+    cl_name_version *extensions = (cl_name_version*)malloc(size);
+    clGetDeviceInfo(device , CL_DEVICE_EXTENSIONS_WITH_VERSION , size , extensions , NULL);
+
+    for(size_t i = 0 ; i < size / sizeof(cl_name_version) ; i++)
+    {
+        if(strcmp(extensions[i].name , COMMAND_BUFFER_EXTENSION) == 0 && extensions[i].version >= CL_MAKE_VERSION(0 , 9 , 5))
+        {
+            found = 1;
+        }
+    }
+
+    free(extensions);
+    return found;
+}
+
+static cmd_khr_api* load_khr_api(cl_device_id device)
+{
+    cl_platform_id platform;
+    cl_bitfield capabilities = 0;
+
+    if(!has_command_buffer_extension(device) ||
+       clGetDeviceInfo(device , CL_DEVICE_PLATFORM , sizeof(platform) , &platform , NULL) != CL_SUCCESS)
+    {
+        return NULL;
+    }
+
+    cmd_khr_api *api = (cmd_khr_api*)calloc(1 , sizeof(cmd_khr_api));
+    api->create = (create_command_buffer_fn)clGetExtensionFunctionAddressForPlatform(platform , "clCreateCommandBufferKHR");
+    api->finalize = (finalize_command_buffer_fn)clGetExtensionFunctionAddressForPlatform(platform , "clFinalizeCommandBufferKHR");
+    api->release = (release_command_buffer_fn)clGetExtensionFunctionAddressForPlatform(platform , "clReleaseCommandBufferKHR");
+    api->enqueue = (enqueue_command_buffer_fn)clGetExtensionFunctionAddressForPlatform(platform , "clEnqueueCommandBufferKHR");
+    api->ndrange_kernel = (command_ndrange_kernel_fn)clGetExtensionFunctionAddressForPlatform(platform , "clCommandNDRangeKernelKHR");
+    api->copy_buffer = (command_copy_buffer_fn)clGetExtensionFunctionAddressForPlatform(platform , "clCommandCopyBufferKHR");
+
+    if(!api->create || !api->finalize || !api->release || !api->enqueue || !api->ndrange_kernel || !api->copy_buffer)
+    {
+        free(api);
+        return NULL;
+    }
+
+    clGetDeviceInfo(device , CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR , sizeof(capabilities) , &capabilities , NULL);
+    api->simultaneous_use = (capabilities & CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR) != 0;
+
+    return api;
+}
+
+void cmd_record_finalize(cmd_recording *rec , int force_emulation)
+{
+    rec->khr = force_emulation ? NULL : load_khr_api(rec->device);
+    rec->use_khr = rec->khr != NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int set_all_args(cmd_entry *entry , const cl_mem *bindings)
+{
+    cl_int err = CL_SUCCESS;
+
+    for(cl_uint i = 0 ; i < entry->num_args && err == CL_SUCCESS ; i++)
+    {
+        if(entry->arg_slots[i] >= 0)
+        {
+            entry->bound[i] = bindings[entry->arg_slots[i]];
+            err = clSetKernelArg(entry->kernel , i , sizeof(cl_mem) , &entry->bound[i]);
+        }
+        else
+        {
+            err = clSetKernelArg(entry->kernel , i , entry->arg_sizes[i] , entry->arg_values[i]);
+        }
+    }
+    return err;
+}
+
+/*
+    1. Kernel arguments are captured when a command is recorded into the command buffer, so the arguments are set right before each command.
+    2. Every command waits on the sync point of the previous one, which keeps the recorded order.
+*/
+static cl_int build_variant(cmd_recording *rec , cmd_variant *variant , const cl_mem *bindings)
+{
+    cmd_khr_api *khr = rec->khr;
+    cmd_sync_point previous = 0 , current;
+    cl_int err;
+
+    cl_properties props[] = {CL_COMMAND_BUFFER_FLAGS_KHR , CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR , 0};
+    variant->buffer = khr->create(1 , &rec->queue , khr->simultaneous_use ? props : NULL , &err);
+    if(err != CL_SUCCESS)
+    {
+        variant->buffer = NULL;
+        return err;
+    }
+
+    for(int i = 0 ; i < rec->num_entries && err == CL_SUCCESS ; i++)
+    {
+        cmd_entry *entry = &rec->entries[i];
+        cl_uint num_waits = i > 0 ? 1 : 0;
+
+        if(entry->type == CMD_KERNEL)
+        {
+            err = set_all_args(entry , bindings);
+            if(err == CL_SUCCESS)
+            {
+                err = khr->ndrange_kernel(variant->buffer , NULL , NULL , entry->kernel , entry->work_dim , NULL , entry->global_size ,
+                                          entry->has_local_size ? entry->local_size : NULL ,
+                                          num_waits , num_waits ? &previous : NULL , &current , NULL);
+            }
+        }
+        else
+        {
+            err = khr->copy_buffer(variant->buffer , NULL , NULL , bindings[entry->src_slot] , bindings[entry->dst_slot] ,
+                                   entry->src_offset , entry->dst_offset , entry->size ,
+                                   num_waits , num_waits ? &previous : NULL , &current , NULL);
+        }
+        previous = current;
+    }
+
+    if(err == CL_SUCCESS)
+    {
+        err = khr->finalize(variant->buffer);
+    }
+    if(err != CL_SUCCESS)
+    {
+        khr->release(variant->buffer);
+        variant->buffer = NULL;
+        return err;
+    }
+
+    memcpy(variant->bindings , bindings , sizeof(cl_mem) * rec->num_slots);
+    variant->pending = NULL;
+    return CL_SUCCESS;
+}
+
+static void release_variant(cmd_recording *rec , cmd_variant *variant)
+{
+    if(variant->pending != NULL)
+    {
+        clWaitForEvents(1 , &variant->pending);
+        clReleaseEvent(variant->pending);
+        variant->pending = NULL;
+    }
+    if(variant->buffer != NULL)
+    {
+        rec->khr->release(variant->buffer);
+        variant->buffer = NULL;
+    }
+}
+
+static cl_int replay_khr(cmd_recording *rec , const cl_mem *bindings , cl_event *event)
+{
+    cmd_variant *variant = NULL;
+    cmd_variant *oldest = &rec->variants[0];
+    cl_event done;
+    cl_int err;
+
+    for(int i = 0 ; i < CMD_RECORD_MAX_VARIANTS && variant == NULL ; i++)
+    {
+        cmd_variant *v = &rec->variants[i];
+        if(v->buffer != NULL && memcmp(v->bindings , bindings , sizeof(cl_mem) * rec->num_slots) == 0)
+        {
+            variant = v;
+        }
+        else if(v->buffer == NULL || (oldest->buffer != NULL && v->last_used < oldest->last_used))
+        {
+            oldest = v;
+        }
+    }
+
+    if(variant == NULL)
+    {
+        // A binding set not seen recently: record a new command buffer in place of the least recently used one
+        if(oldest->buffer != NULL)
+        {
+            release_variant(rec , oldest);
+        }
+        err = build_variant(rec , oldest , bindings);
+        if(err != CL_SUCCESS)
+        {
+            return err;
+        }
+        variant = oldest;
+    }
+
+    // Without simultaneous use a command buffer can't be enqueued again while it is still pending
+    if(variant->pending != NULL)
+    {
+        clWaitForEvents(1 , &variant->pending);
+        clReleaseEvent(variant->pending);
+        variant->pending = NULL;
+    }
+
+    err = rec->khr->enqueue(0 , NULL , variant->buffer , 0 , NULL , (event || !rec->khr->simultaneous_use) ? &done : NULL);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    if(!rec->khr->simultaneous_use)
+    {
+        variant->pending = done;
+        if(event != NULL)
+        {
+            clRetainEvent(done);
+        }
+    }
+    if(event != NULL)
+    {
+        *event = done;
+    }
+
+    variant->last_used = ++rec->replays;
+    return CL_SUCCESS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int replay_emulated(cmd_recording *rec , const cl_mem *bindings , cl_event *event)
+{
+    cl_int err = CL_SUCCESS;
+
+    for(int i = 0 ; i < rec->num_entries && err == CL_SUCCESS ; i++)
+    {
+        cmd_entry *entry = &rec->entries[i];
+        cl_event *entry_event = (event != NULL && i == rec->num_entries - 1) ? event : NULL;
+
+        if(entry->type == CMD_COPY)
+        {
+            err = clEnqueueCopyBuffer(rec->queue , bindings[entry->src_slot] , bindings[entry->dst_slot] ,
+                                      entry->src_offset , entry->dst_offset , entry->size , 0 , NULL , entry_event);
+            continue;
+        }
+
+        if(!entry->is_clone)
+        {
+            // The caller's kernel may be shared with other launches, so every argument is set again
+            err = set_all_args(entry , bindings);
+        }
+        else
+        {
+            for(cl_uint a = 0 ; a < entry->num_args && err == CL_SUCCESS ; a++)
+            {
+                int slot = entry->arg_slots[a];
+                if(slot >= 0 && entry->bound[a] != bindings[slot])
+                {
+                    entry->bound[a] = bindings[slot];
+                    err = clSetKernelArg(entry->kernel , a , sizeof(cl_mem) , &entry->bound[a]);
+                }
+            }
+        }
+
+        if(err == CL_SUCCESS)
+        {
+            err = clEnqueueNDRangeKernel(rec->queue , entry->kernel , entry->work_dim , NULL , entry->global_size ,
+                                         entry->has_local_size ? entry->local_size : NULL , 0 , NULL , entry_event);
+        }
+    }
+
+    rec->replays++;
+    return err;
+}
+
+cl_int cmd_replay(cmd_recording *rec , const cl_mem *bindings , cl_event *event)
+{
+    if(rec->use_khr)
+    {
+        if(replay_khr(rec , bindings , event) == CL_SUCCESS)
+        {
+            return CL_SUCCESS;
+        }
+
+        // The driver refused the command buffer, so stay on the emulated path from now on
+        for(int i = 0 ; i < CMD_RECORD_MAX_VARIANTS ; i++)
+        {
+            release_variant(rec , &rec->variants[i]);
+        }
+        rec->use_khr = 0;
+        for(int i = 0 ; i < rec->num_entries ; i++)
+        {
+            memset(rec->entries[i].bound , 0 , sizeof(rec->entries[i].bound));
+        }
+    }
+
+    return replay_emulated(rec , bindings , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void cmd_record_release(cmd_recording *rec)
+{
+    if(rec->khr != NULL)
+    {
+        for(int i = 0 ; i < CMD_RECORD_MAX_VARIANTS ; i++)
+        {
+            release_variant(rec , &rec->variants[i]);
+        }
+        free(rec->khr);
+    }
+
+    for(int i = 0 ; i < rec->num_entries ; i++)
+    {
+        release_entry(&rec->entries[i]);
+    }
+    free(rec->entries);
+
+    memset(rec , 0 , sizeof(*rec));
+}
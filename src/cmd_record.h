@@ -0,0 +1,120 @@
+/*
+
+Recorded Command Sequences
+--------------------------
+
+1. A recording is a fixed sequence of kernel launches and buffer copies. Buffers are referenced through numbered slots,
+   and every replay passes the cl_mem bound to each slot, so one recording can run on different buffers.
+2. Scalar arguments , work sizes and the command order are fixed when the sequence is recorded.
+3. With cl_khr_command_buffer (version 0.9.5 or newer) the sequence is recorded once into a command buffer and each replay
+   is a single clEnqueueCommandBufferKHR call. A command buffer bakes in its buffers, so one is kept for each of the last
+   CMD_RECORD_MAX_VARIANTS binding sets (ping-pong buffers need two).
+4. Without the extension the sequence is emulated: every launch gets its own clone of the kernel (clCloneKernel), whose
+   fixed arguments are set once. A replay only calls clSetKernelArg for slots whose buffer changed, then enqueues.
+   Before OpenCL 2.1 there is no clone: the caller's kernel is retained until cmd_record_release and every argument is set
+   again on each replay.
+5. Replays go to the queue given to cmd_record_init.
+
+*/
+
+#ifndef CMD_RECORD_H
+#define CMD_RECORD_H
+
+#include <stddef.h>
+
+#ifdef MAC
+#include <OpenCL/cl.h>
+#else
+#ifndef CL_TARGET_OPENCL_VERSION
+#define CL_TARGET_OPENCL_VERSION 300
+#endif
+#include <CL/cl.h>
+#endif
+
+#define CMD_RECORD_MAX_ARGS 16
+#define CMD_RECORD_MAX_SLOTS 16
+#define CMD_RECORD_MAX_VARIANTS 4
+
+typedef struct
+{
+    size_t size;
+    const void *value;
+    int slot;                   // >= 0 binds the argument to a buffer slot , value is ignored
+} cmd_arg;
+
+#define CMD_ARG_SLOT(index) ((cmd_arg){sizeof(cl_mem) , NULL , (index)})
+#define CMD_ARG_VALUE(variable) ((cmd_arg){sizeof(variable) , &(variable) , -1})
+
+typedef enum
+{
+    CMD_KERNEL,
+    CMD_COPY
+} cmd_type;
+
+typedef struct
+{
+    cmd_type type;
+
+    cl_kernel kernel;           // clone , or the caller's kernel retained when cloning is not available
+    int owns_kernel;            // the recording holds a reference on kernel and releases it
+    int is_clone;               // kernel is private , so its arguments stay bound between replays
+    cl_uint work_dim;
+    size_t global_size[3];
+    size_t local_size[3];
+    int has_local_size;
+    cl_uint num_args;
+    int arg_slots[CMD_RECORD_MAX_ARGS];
+    size_t arg_sizes[CMD_RECORD_MAX_ARGS];
+    unsigned char *arg_values[CMD_RECORD_MAX_ARGS];
+    cl_mem bound[CMD_RECORD_MAX_ARGS];          // buffer currently set on the kernel for each slot argument
+
+    int src_slot;
+    int dst_slot;
+    size_t src_offset;
+    size_t dst_offset;
+    size_t size;
+} cmd_entry;
+
+typedef struct _cmd_khr_buffer* cmd_khr_buffer;
+typedef struct cmd_khr_api cmd_khr_api;
+
+typedef struct
+{
+    cmd_khr_buffer buffer;
+    cl_mem bindings[CMD_RECORD_MAX_SLOTS];
+    cl_event pending;           // last enqueue , when the device can't run a command buffer while it is still pending
+    unsigned long last_used;
+} cmd_variant;
+
+typedef struct
+{
+    cl_context context;
+    cl_device_id device;
+    cl_command_queue queue;
+
+    cmd_entry *entries;
+    int num_entries;
+    int capacity;
+    int num_slots;
+
+    int use_khr;
+    cmd_khr_api *khr;
+    cmd_variant variants[CMD_RECORD_MAX_VARIANTS];
+    unsigned long replays;
+} cmd_recording;
+
+void cmd_record_init(cmd_recording *rec , cl_context context , cl_device_id device , cl_command_queue queue);
+
+cl_int cmd_record_kernel(cmd_recording *rec , cl_kernel kernel , cl_uint work_dim , const size_t *global_size , const size_t *local_size ,
+                         cl_uint num_args , const cmd_arg *args);
+cl_int cmd_record_copy(cmd_recording *rec , int src_slot , int dst_slot , size_t src_offset , size_t dst_offset , size_t size);
+
+// Ends recording and picks the command buffer or the emulated path. force_emulation skips the extension (for comparisons).
+void cmd_record_finalize(cmd_recording *rec , int force_emulation);
+
+// Enqueues the whole sequence with bindings[slot] as the buffer of each slot. Does not wait for completion.
+cl_int cmd_replay(cmd_recording *rec , const cl_mem *bindings , cl_event *event);
+
+void cmd_record_release(cmd_recording *rec);
+
+#endif
@@ -0,0 +1,403 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "compute.h"
+#include "specialize.h"
+#include "vector_ops.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void compute_init(compute_context *ctx)
+{
+    cl_platform_id platform;
+    cl_int err;
+
+    ctx->has_opencl = 0;
+    ctx->context = NULL;
+    ctx->queue = NULL;
+    ctx->pool = thread_pool_create(0);
+    ctx->offload_threshold = COMPUTE_OFFLOAD_THRESHOLD;
+    ctx->perf = NULL;
+
+    err = clGetPlatformIDs(1 , &platform , NULL);
+    if(err < 0)
+    {
+        printf("No OpenCL platform found (%d) , using the CPU backend only.\n", err);
+        return;
+    }
+
+    err = clGetDeviceIDs(platform , CL_DEVICE_TYPE_GPU , 1 , &ctx->device , NULL);
+    if(err < 0)
+    {
+        err = clGetDeviceIDs(platform , CL_DEVICE_TYPE_ALL , 1 , &ctx->device , NULL);
+    }
+    if(err < 0)
+    {
+        printf("No OpenCL device found (%d) , using the CPU backend only.\n", err);
+        return;
+    }
+
+    ctx->context = clCreateContext(NULL , 1 , &ctx->device , NULL , NULL , &err);
+    if(err < 0)
+    {
+        printf("Couldn't create an OpenCL context (%d) , using the CPU backend only.\n", err);
+        return;
+    }
+
+    ctx->queue = clCreateCommandQueueWithProperties(ctx->context , ctx->device , NULL , &err);
+    if(err < 0)
+    {
+        printf("Couldn't create an OpenCL queue (%d) , using the CPU backend only.\n", err);
+        clReleaseContext(ctx->context);
+        ctx->context = NULL;
+        return;
+    }
+
+    kernel_cache_init(&ctx->cache , ctx->context , ctx->device);
+    ctx->has_opencl = 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void compute_release(compute_context *ctx)
+{
+    if(ctx->has_opencl)
+    {
+        kernel_cache_release(&ctx->cache);
+        clReleaseCommandQueue(ctx->queue);
+        clReleaseContext(ctx->context);
+        ctx->has_opencl = 0;
+    }
+    thread_pool_destroy(ctx->pool);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+const char* compute_backend_name(compute_backend backend)
+{
+    switch(backend)
+    {
+        case BACKEND_CPU: return "cpu";
+        case BACKEND_OPENCL: return "opencl";
+        default: return "auto";
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static compute_backend resolve_backend(compute_context *ctx , compute_backend backend , size_t bytes_moved)
+{
+    if(!ctx->has_opencl)
+    {
+        return BACKEND_CPU;
+    }
+    if(backend == BACKEND_AUTO)
+    {
+        return bytes_moved < ctx->offload_threshold ? BACKEND_CPU : BACKEND_OPENCL;
+    }
+    return backend;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Instrumentation regions , no-ops unless ctx->perf is set
+static void region_begin(compute_context *ctx)
+{
+    if(ctx->perf != NULL)
+    {
+        perf_region_begin(ctx->perf);
+    }
+}
+
+static void region_end(compute_context *ctx , const char *name , const char *suffix , double bytes , double flops)
+{
+    char label[PERF_NAME_LEN];
+
+    if(ctx->perf != NULL)
+    {
+        snprintf(label , sizeof(label) , "%s%s" , name , suffix);
+        perf_region_end(ctx->perf , ctx->queue , label , bytes , flops);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/*
+    1. Runs kernel(in0 , in1 , out [, extra]) over global_size work-items.
+    2. Inputs are copied with CL_MEM_COPY_HOST_PTR , and the output is read back with a blocking read.
+    3. name and flops label the instrumentation regions.
+*/
+static cl_int run_two_in_one_out(compute_context *ctx , const char *name , cl_kernel kernel ,
+                                 const void *in0 , size_t in0_bytes , const void *in1 , size_t in1_bytes ,
+                                 void *out , size_t out_bytes , const int *extra , size_t global_size , double flops)
+{
+    cl_mem in0_buff , in1_buff , out_buff;
+    cl_int err , status;
+
+    region_begin(ctx);
+    in0_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , in0_bytes , (void*)in0 , &err);
+    if(err < 0)
+    {
+        return err;
+    }
+
+    in1_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , in1_bytes , (void*)in1 , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(in0_buff);
+        return err;
+    }
+
+    out_buff = clCreateBuffer(ctx->context , CL_MEM_WRITE_ONLY , out_bytes , NULL , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(in0_buff);
+        clReleaseMemObject(in1_buff);
+        return err;
+    }
+    region_end(ctx , name , ":write" , (double)(in0_bytes + in1_bytes) , 0.0);
+
+    status  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in0_buff);
+    status |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &in1_buff);
+    status |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &out_buff);
+    if(extra != NULL)
+    {
+        status |= clSetKernelArg(kernel , 3 , sizeof(int) , extra);
+    }
+
+    if(status == CL_SUCCESS)
+    {
+        region_begin(ctx);
+        status = clEnqueueNDRangeKernel(ctx->queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , NULL);
+        region_end(ctx , name , "" , (double)(in0_bytes + in1_bytes + out_bytes) , flops);
+    }
+    if(status == CL_SUCCESS)
+    {
+        region_begin(ctx);
+        status = clEnqueueReadBuffer(ctx->queue , out_buff , CL_TRUE , 0 , out_bytes , out , 0 , NULL , NULL);
+        region_end(ctx , name , ":read" , (double)out_bytes , 0.0);
+    }
+
+    clReleaseMemObject(in0_buff);
+    clReleaseMemObject(in1_buff);
+    clReleaseMemObject(out_buff);
+
+    return status;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int elementwise_opencl(compute_context *ctx , const char *name , elementwise_op op ,
+                                 const float *a , const float *b , float *result , size_t n)
+{
+    size_t bytes = n * sizeof(float);
+    cl_mem a_buff , b_buff , out_buff;
+    cl_int err , status;
+
+    // Vector width and work per work-item from the device capabilities. Fetched before any region , so none counts the build.
+    int width = 0 , items_per_work_item = 0;
+    cl_kernel kernel = elementwise_kernel(&ctx->cache , op , &width , &items_per_work_item);
+
+    region_begin(ctx);
+    a_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , (void*)a , &err);
+    if(err < 0)
+    {
+        return err;
+    }
+    b_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , (void*)b , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(a_buff);
+        return err;
+    }
+    out_buff = clCreateBuffer(ctx->context , CL_MEM_WRITE_ONLY , bytes , NULL , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(a_buff);
+        clReleaseMemObject(b_buff);
+        return err;
+    }
+    region_end(ctx , name , ":write" , 2.0 * bytes , 0.0);
+
+    region_begin(ctx);
+    status = enqueue_elementwise(ctx->queue , kernel , a_buff , b_buff , out_buff , (int)n , width , items_per_work_item , NULL);
+    region_end(ctx , name , "" , 3.0 * bytes , (double)n);
+    if(status == CL_SUCCESS)
+    {
+        region_begin(ctx);
+        status = clEnqueueReadBuffer(ctx->queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+        region_end(ctx , name , ":read" , (double)bytes , 0.0);
+    }
+
+    clReleaseMemObject(a_buff);
+    clReleaseMemObject(b_buff);
+    clReleaseMemObject(out_buff);
+    return status;
+}
+
+static compute_backend binary_op(compute_context *ctx , compute_backend backend , const char *name , elementwise_op op ,
+                                 void (*cpu_func)(thread_pool* , const float* , const float* , float* , size_t) ,
+                                 const float *a , const float *b , float *result , size_t n)
+{
+    // The elementwise kernels index with int , so a larger n stays on the host
+    backend = n > INT_MAX ? BACKEND_CPU : resolve_backend(ctx , backend , n * sizeof(float) * 3);
+    if(backend == BACKEND_OPENCL && elementwise_opencl(ctx , name , op , a , b , result , n) == CL_SUCCESS)
+    {
+        return BACKEND_OPENCL;
+    }
+
+    cpu_func(ctx->pool , a , b , result , n);
+    return BACKEND_CPU;
+}
+
+compute_backend compute_add_arrays(compute_context *ctx , compute_backend backend , const float *A , const float *B , float *C , size_t n)
+{
+    return binary_op(ctx , backend , "add_arrays" , ELEMENTWISE_ADD , cpu_add_arrays , A , B , C , n);
+}
+
+compute_backend compute_mult(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n)
+{
+    return binary_op(ctx , backend , "mult" , ELEMENTWISE_MULT , cpu_mult , a , b , result , n);
+}
+
+compute_backend compute_add(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n)
+{
+    return binary_op(ctx , backend , "add" , ELEMENTWISE_ADD , cpu_add , a , b , result , n);
+}
+
+compute_backend compute_sub(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n)
+{
+    return binary_op(ctx , backend , "sub" , ELEMENTWISE_SUB , cpu_sub , a , b , result , n);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+compute_backend compute_mat_vec_mult(compute_context *ctx , compute_backend backend , const float *matrix , const float *vector ,
+                                     float *result , size_t rows , size_t cols)
+{
+    size_t mat_bytes = rows * cols * sizeof(float);
+    size_t vec_bytes = cols * sizeof(float);
+    size_t res_bytes = rows * sizeof(float);
+
+    backend = resolve_backend(ctx , backend , mat_bytes + vec_bytes + res_bytes);
+    if(backend == BACKEND_OPENCL)
+    {
+        int num_cols = (int)cols;
+        cl_kernel kernel = kernel_cache_get(&ctx->cache , "mat_vec.cl" , "mat_vec_mult_n" , NULL);
+        if(run_two_in_one_out(ctx , "mat_vec_mult_n" , kernel , matrix , mat_bytes , vector , vec_bytes , result , res_bytes ,
+                              &num_cols , rows , 2.0 * rows * cols) == CL_SUCCESS)
+        {
+            return BACKEND_OPENCL;
+        }
+    }
+
+    cpu_mat_vec_mult(ctx->pool , matrix , vector , result , rows , cols);
+    return BACKEND_CPU;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int gray_opencl(compute_context *ctx , unsigned char *pOut , const unsigned char *pIn , int width , int height)
+{
+    size_t num_pixels = (size_t)width * height;
+    cl_mem in_buff , out_buff;
+    cl_int err , status;
+
+    cl_kernel kernel = kernel_cache_get(&ctx->cache , "grayscale.cl" , "rgbToGrayScale" , NULL);
+
+    region_begin(ctx);
+    in_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , num_pixels * 3 , (void*)pIn , &err);
+    if(err < 0)
+    {
+        return err;
+    }
+    out_buff = clCreateBuffer(ctx->context , CL_MEM_WRITE_ONLY , num_pixels , NULL , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(in_buff);
+        return err;
+    }
+    region_end(ctx , "rgbToGrayScale" , ":write" , num_pixels * 3.0 , 0.0);
+
+    status  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &out_buff);
+    status |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &in_buff);
+    status |= clSetKernelArg(kernel , 2 , sizeof(int) , &width);
+    status |= clSetKernelArg(kernel , 3 , sizeof(int) , &height);
+
+    size_t local_size[2] = {16 , 16};
+    size_t global_size[2] = {(width + 15) / 16 * 16 , (height + 15) / 16 * 16};
+    if(status == CL_SUCCESS)
+    {
+        // 3 multiplies and 2 adds per pixel
+        region_begin(ctx);
+        status = clEnqueueNDRangeKernel(ctx->queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , NULL);
+        region_end(ctx , "rgbToGrayScale" , "" , num_pixels * 4.0 , num_pixels * 5.0);
+    }
+    if(status == CL_SUCCESS)
+    {
+        region_begin(ctx);
+        status = clEnqueueReadBuffer(ctx->queue , out_buff , CL_TRUE , 0 , num_pixels , pOut , 0 , NULL , NULL);
+        region_end(ctx , "rgbToGrayScale" , ":read" , (double)num_pixels , 0.0);
+    }
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+    return status;
+}
+
+compute_backend compute_rgb_to_gray(compute_context *ctx , compute_backend backend , unsigned char *pOut , const unsigned char *pIn ,
+                                    int width , int height)
+{
+    backend = resolve_backend(ctx , backend , (size_t)width * height * 4);
+    if(backend == BACKEND_OPENCL && gray_opencl(ctx , pOut , pIn , width , height) == CL_SUCCESS)
+    {
+        return BACKEND_OPENCL;
+    }
+
+    cpu_rgb_to_gray(ctx->pool , pOut , pIn , width , height);
+    return BACKEND_CPU;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int blur_opencl(compute_context *ctx , const unsigned char *pIn , unsigned char *pOut , int width , int height , int radius)
+{
+    size_t image_bytes = (size_t)width * height * 3;
+    cl_mem in_buff , out_buff;
+    cl_int err , status;
+
+    cl_kernel kernel = blur_kernel(&ctx->cache , radius , VARIANT_AUTO);
+
+    region_begin(ctx);
+    in_buff = clCreateBuffer(ctx->context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , image_bytes , (void*)pIn , &err);
+    if(err < 0)
+    {
+        return err;
+    }
+    out_buff = clCreateBuffer(ctx->context , CL_MEM_WRITE_ONLY , image_bytes , NULL , &err);
+    if(err < 0)
+    {
+        clReleaseMemObject(in_buff);
+        return err;
+    }
+    region_end(ctx , "blurKernel" , ":write" , (double)image_bytes , 0.0);
+
+    region_begin(ctx);
+    status = enqueue_blur(ctx->queue , kernel , in_buff , out_buff , width , height , radius , NULL);
+    // Integer sums and divides: no flops , so the report gives no GFLOP/s or B/flop for it
+    region_end(ctx , "blurKernel" , "" , 2.0 * image_bytes , 0.0);
+    if(status == CL_SUCCESS)
+    {
+        region_begin(ctx);
+        status = clEnqueueReadBuffer(ctx->queue , out_buff , CL_TRUE , 0 , image_bytes , pOut , 0 , NULL , NULL);
+        region_end(ctx , "blurKernel" , ":read" , (double)image_bytes , 0.0);
+    }
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+    return status;
+}
+
+compute_backend compute_blur(compute_context *ctx , compute_backend backend , const unsigned char *pIn , unsigned char *pOut ,
+                             int width , int height , int radius)
+{
+    backend = resolve_backend(ctx , backend , (size_t)width * height * 6);
+    if(backend == BACKEND_OPENCL && blur_opencl(ctx , pIn , pOut , width , height , radius) == CL_SUCCESS)
+    {
+        return BACKEND_OPENCL;
+    }
+
+    cpu_blur(ctx->pool , pIn , pOut , width , height , radius);
+    return BACKEND_CPU;
+}
@@ -0,0 +1,68 @@
+/*
+
+Backend Selection
+-----------------
+
+1. One entry point per kernel , each taking host arrays and a compute_backend.
+2. BACKEND_OPENCL copies the inputs to the device , launches the kernel and reads the result back.
+3. BACKEND_CPU runs the native implementation from cpu_backend.h on the host thread pool.
+4. BACKEND_AUTO runs on the CPU when no OpenCL device was found , or when the bytes moved are below offload_threshold:
+   for small problems the device round trip costs more than the computation.
+5. compute_init never exits when OpenCL is missing. It only clears has_opencl , so the program keeps working on hosts without an ICD.
+6. Every call returns the backend that actually ran. An OpenCL error falls back to the CPU , and so does an elementwise call
+   with n above INT_MAX , which the kernels cannot index.
+7. Setting perf to a perf_session (perf_counters.h) turns on instrumentation: every upload , launch and read back of the OpenCL
+   backend becomes its own synchronous region , named after the kernel ("add_arrays:write" , "add_arrays" , "add_arrays:read")
+   with its nominal bytes and flops. Kernels are fetched from the cache before the first region , so no region includes a
+   program build. perf is NULL after compute_init.
+
+*/
+
+#ifndef COMPUTE_H
+#define COMPUTE_H
+
+#include "cpu_backend.h"
+#include "kernel_cache.h"
+#include "perf_counters.h"
+
+#define COMPUTE_OFFLOAD_THRESHOLD (4 << 20)
+
+typedef enum
+{
+    BACKEND_AUTO,
+    BACKEND_CPU,
+    BACKEND_OPENCL
+} compute_backend;
+
+typedef struct
+{
+    int has_opencl;
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue queue;
+    kernel_cache cache;
+    thread_pool *pool;
+    size_t offload_threshold;
+    perf_session *perf;
+} compute_context;
+
+void compute_init(compute_context *ctx);
+void compute_release(compute_context *ctx);
+
+const char* compute_backend_name(compute_backend backend);
+
+compute_backend compute_add_arrays(compute_context *ctx , compute_backend backend , const float *A , const float *B , float *C , size_t n);
+compute_backend compute_mult(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n);
+compute_backend compute_add(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n);
+compute_backend compute_sub(compute_context *ctx , compute_backend backend , const float *a , const float *b , float *result , size_t n);
+
+compute_backend compute_mat_vec_mult(compute_context *ctx , compute_backend backend , const float *matrix , const float *vector ,
+                                     float *result , size_t rows , size_t cols);
+
+compute_backend compute_rgb_to_gray(compute_context *ctx , compute_backend backend , unsigned char *pOut , const unsigned char *pIn ,
+                                    int width , int height);
+
+compute_backend compute_blur(compute_context *ctx , compute_backend backend , const unsigned char *pIn , unsigned char *pOut ,
+                             int width , int height , int radius);
+
+#endif
@@ -0,0 +1,299 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "convolve.h"
+
+#define SEPARABLE_TOLERANCE 1e-5f
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int conv_filter_custom(conv_filter *filter , int size , const float *weights , float scale , float bias)
+{
+    if(size < 1 || size > CONV_MAX_SIZE || size % 2 == 0)
+    {
+        return -1;
+    }
+
+    filter->size = size;
+    memcpy(filter->weights , weights , sizeof(float) * size * size);
+    filter->scale = scale;
+    filter->bias = bias;
+    return 0;
+}
+
+int conv_filter_box(conv_filter *filter , int size)
+{
+    float weights[CONV_MAX_SIZE * CONV_MAX_SIZE];
+
+    if(size < 1 || size > CONV_MAX_SIZE)
+    {
+        return -1;
+    }
+    for(int i = 0 ; i < size * size ; i++)
+    {
+        weights[i] = 1.0f / (size * size);
+    }
+    return conv_filter_custom(filter , size , weights , 1.0f , 0.0f);
+}
+
+int conv_filter_gaussian(conv_filter *filter , int size , float sigma)
+{
+    float weights[CONV_MAX_SIZE * CONV_MAX_SIZE];
+    float taps[CONV_MAX_SIZE];
+    float total = 0.0f;
+    int radius = size / 2;
+
+    if(size < 1 || size > CONV_MAX_SIZE)
+    {
+        return -1;
+    }
+
+    for(int i = 0 ; i < size ; i++)
+    {
+        float d = (float)(i - radius);
+        taps[i] = expf(-d * d / (2.0f * sigma * sigma));
+        total += taps[i];
+    }
+
+    // Outer product of the normalized 1D taps , so the 2D weights sum to 1
+    for(int y = 0 ; y < size ; y++)
+    {
+        for(int x = 0 ; x < size ; x++)
+        {
+            weights[y * size + x] = taps[y] * taps[x] / (total * total);
+        }
+    }
+    return conv_filter_custom(filter , size , weights , 1.0f , 0.0f);
+}
+
+static void gradient_filter(conv_filter *filter , int vertical , float edge , float centre , float scale)
+{
+    const float horizontal[9] = {-edge , 0.0f , edge ,
+                                 -centre , 0.0f , centre ,
+                                 -edge , 0.0f , edge};
+    float weights[9];
+
+    for(int y = 0 ; y < 3 ; y++)
+    {
+        for(int x = 0 ; x < 3 ; x++)
+        {
+            weights[y * 3 + x] = vertical ? horizontal[x * 3 + y] : horizontal[y * 3 + x];
+        }
+    }
+
+    // Signed gradient mapped to 0..255 with 0 at mid gray
+    conv_filter_custom(filter , 3 , weights , scale , 128.0f);
+}
+
+void conv_filter_sobel(conv_filter *filter , int vertical)
+{
+    gradient_filter(filter , vertical , 1.0f , 2.0f , 1.0f / 8.0f);
+}
+
+void conv_filter_scharr(conv_filter *filter , int vertical)
+{
+    gradient_filter(filter , vertical , 3.0f , 10.0f , 1.0f / 32.0f);
+}
+
+void conv_filter_sharpen(conv_filter *filter)
+{
+    const float weights[9] = { 0.0f , -1.0f ,  0.0f ,
+                              -1.0f ,  5.0f , -1.0f ,
+                               0.0f , -1.0f ,  0.0f};
+
+    conv_filter_custom(filter , 3 , weights , 1.0f , 0.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/*
+    1. A separable filter is the outer product col * row^T , so every row of the weights is a multiple of every other row.
+    2. The largest weight (py , px) is used as the pivot: col = column px , row = row py / pivot.
+    3. The filter is separable when col[y] * row[x] reproduces every weight within SEPARABLE_TOLERANCE of the largest weight.
+*/
+int conv_filter_separate(const conv_filter *filter , float *col_weights , float *row_weights)
+{
+    int size = filter->size;
+    int px = 0 , py = 0;
+    float largest = 0.0f;
+
+    for(int y = 0 ; y < size ; y++)
+    {
+        for(int x = 0 ; x < size ; x++)
+        {
+            if(fabsf(filter->weights[y * size + x]) > largest)
+            {
+                largest = fabsf(filter->weights[y * size + x]);
+                px = x;
+                py = y;
+            }
+        }
+    }
+    if(largest == 0.0f)
+    {
+        return 0;
+    }
+
+    float pivot = filter->weights[py * size + px];
+    for(int i = 0 ; i < size ; i++)
+    {
+        col_weights[i] = filter->weights[i * size + px];
+        row_weights[i] = filter->weights[py * size + i] / pivot;
+    }
+
+    for(int y = 0 ; y < size ; y++)
+    {
+        for(int x = 0 ; x < size ; x++)
+        {
+            if(fabsf(col_weights[y] * row_weights[x] - filter->weights[y * size + x]) > SEPARABLE_TOLERANCE * largest)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int conv_plan_create(conv_plan *plan , cl_context context , const conv_filter *filter , int allow_separable)
+{
+    cl_int err;
+
+    memset(plan , 0 , sizeof(*plan));
+    plan->context = context;
+    plan->filter = *filter;
+    plan->separable = allow_separable && filter->size > 1 && conv_filter_separate(filter , plan->col_weights , plan->row_weights);
+
+    if(plan->separable)
+    {
+        size_t bytes = sizeof(float) * filter->size;
+        plan->weights_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , plan->row_weights , &err);
+        if(err < 0)
+        {
+            return err;
+        }
+        plan->col_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , plan->col_weights , &err);
+        if(err < 0)
+        {
+            clReleaseMemObject(plan->weights_buff);
+            plan->weights_buff = NULL;
+            return err;
+        }
+    }
+    else
+    {
+        size_t bytes = sizeof(float) * filter->size * filter->size;
+        plan->weights_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , plan->filter.weights , &err);
+        if(err < 0)
+        {
+            return err;
+        }
+    }
+
+    return CL_SUCCESS;
+}
+
+void conv_plan_release(conv_plan *plan)
+{
+    if(plan->weights_buff != NULL)
+    {
+        clReleaseMemObject(plan->weights_buff);
+    }
+    if(plan->col_buff != NULL)
+    {
+        clReleaseMemObject(plan->col_buff);
+    }
+    if(plan->scratch != NULL)
+    {
+        clReleaseMemObject(plan->scratch);
+    }
+    memset(plan , 0 , sizeof(*plan));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int launch_convolve(kernel_cache *cache , cl_command_queue queue , conv_plan *plan , cl_mem in , cl_mem out ,
+                       int width , int height , int channels , conv_border border , cl_event *event)
+{
+    char options[96];
+    cl_kernel kernel;
+    cl_int err;
+
+    if(channels < 1 || channels > 4)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    snprintf(options , sizeof(options) , "-DKSIZE=%d -DCHANNELS=%d -DBORDER=%d -DTILE_W=%d -DTILE_H=%d",
+             plan->filter.size , channels , (int)border , CONV_TILE , CONV_TILE);
+
+    size_t local_size[2] = {CONV_TILE , CONV_TILE};
+    size_t global_size[2] = {(width + CONV_TILE - 1) / CONV_TILE * CONV_TILE , (height + CONV_TILE - 1) / CONV_TILE * CONV_TILE};
+
+    if(!plan->separable)
+    {
+        kernel = kernel_cache_get(cache , CONVOLVE_PROGRAM , "convolve2d" , options);
+
+        err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+        err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+        err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &plan->weights_buff);
+        err |= clSetKernelArg(kernel , 3 , sizeof(int) , &width);
+        err |= clSetKernelArg(kernel , 4 , sizeof(int) , &height);
+        err |= clSetKernelArg(kernel , 5 , sizeof(float) , &plan->filter.scale);
+        err |= clSetKernelArg(kernel , 6 , sizeof(float) , &plan->filter.bias);
+        if(err != CL_SUCCESS)
+        {
+            return err;
+        }
+
+        return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+    }
+
+    // Separable: row pass into the float scratch image , then the column pass
+    size_t scratch_bytes = (size_t)width * height * channels * sizeof(float);
+    if(plan->scratch_bytes < scratch_bytes)
+    {
+        if(plan->scratch != NULL)
+        {
+            clReleaseMemObject(plan->scratch);
+        }
+        plan->scratch = clCreateBuffer(plan->context , CL_MEM_READ_WRITE , scratch_bytes , NULL , &err);
+        if(err < 0)
+        {
+            plan->scratch = NULL;
+            plan->scratch_bytes = 0;
+            return err;
+        }
+        plan->scratch_bytes = scratch_bytes;
+    }
+
+    kernel = kernel_cache_get(cache , CONVOLVE_PROGRAM , "convolveRows" , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &plan->scratch);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &plan->weights_buff);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &height);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , NULL);
+    }
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = kernel_cache_get(cache , CONVOLVE_PROGRAM , "convolveCols" , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &plan->scratch);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &plan->col_buff);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &height);
+    err |= clSetKernelArg(kernel , 5 , sizeof(float) , &plan->filter.scale);
+    err |= clSetKernelArg(kernel , 6 , sizeof(float) , &plan->filter.bias);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
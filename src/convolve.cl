@@ -0,0 +1,237 @@
+/*
+    2D convolution of interleaved 8-bit images. The macros below are supplied as -D build options by launch_convolve (convolve.c).
+
+    KSIZE           filter width and height , odd
+    CHANNELS        interleaved channels per pixel , 1 to 4
+    BORDER          0 clamp , 1 mirror , 2 zero
+    TILE_W , TILE_H work-group size (default 16 x 16). Kernels must be launched with exactly this local size.
+
+    1. Weights are a __constant argument. All work-items of a group read the same weight at the same time , which the constant
+       cache serves as a broadcast.
+    2. Each work-group first copies its tile plus a halo of KSIZE / 2 pixels on every side into local memory , so an input pixel is
+       read from global memory about once per work-group instead of KSIZE * KSIZE times.
+    3. The border mode is applied while loading the tile , so the inner loops have no bounds checks.
+    4. Weights are applied as a correlation (not flipped): weights[0] multiplies the top left neighbour.
+    5. convolveRows and convolveCols are the two passes of a separable filter. The intermediate image is float , so the result is
+       rounded only once.
+*/
+
+#ifndef KSIZE
+#define KSIZE 3
+#endif
+
+#ifndef CHANNELS
+#define CHANNELS 1
+#endif
+
+#ifndef BORDER
+#define BORDER 0
+#endif
+
+#ifndef TILE_W
+#define TILE_W 16
+#endif
+
+#ifndef TILE_H
+#define TILE_H 16
+#endif
+
+#define RADIUS (KSIZE / 2)
+#define BORDER_CLAMP 0
+#define BORDER_MIRROR 1
+#define BORDER_ZERO 2
+
+// Maps a coordinate outside [0 , n) back into the image. Mirror reflects around the edge pixel: ... 2 1 | 0 1 2 ...
+inline int border_coord(int i , int n)
+{
+#if BORDER == BORDER_MIRROR
+    if(i < 0)
+    {
+        i = -i;
+    }
+    if(i >= n)
+    {
+        i = 2 * n - 2 - i;
+    }
+#endif
+    return clamp(i , 0 , n - 1);
+}
+
+// Zero border: coordinates outside the image read as 0
+inline int inside(int i , int n)
+{
+#if BORDER == BORDER_ZERO
+    return i >= 0 && i < n;
+#else
+    return 1;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+__kernel void convolve2d(__global const uchar *pIn , __global uchar *pOut , __constant float *weights ,
+                         int width , int height , float scale , float bias)
+{
+    __local uchar tile[TILE_H + 2 * RADIUS][(TILE_W + 2 * RADIUS) * CHANNELS];
+
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+    int originX = get_group_id(0) * TILE_W - RADIUS;
+    int originY = get_group_id(1) * TILE_H - RADIUS;
+
+    for(int ty = localRow ; ty < TILE_H + 2 * RADIUS ; ty += TILE_H)
+    {
+        int y = originY + ty;
+        int rowInside = inside(y , height);
+        int rowOffset = border_coord(y , height) * width;
+
+        for(int tx = localCol ; tx < TILE_W + 2 * RADIUS ; tx += TILE_W)
+        {
+            int x = originX + tx;
+            int valid = rowInside && inside(x , width);
+            int offset = (rowOffset + border_coord(x , width)) * CHANNELS;
+
+            for(int c = 0 ; c < CHANNELS ; c++)
+            {
+                tile[ty][tx * CHANNELS + c] = valid ? pIn[offset + c] : 0;
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    for(int ky = 0 ; ky < KSIZE ; ky++)
+    {
+        for(int kx = 0 ; kx < KSIZE ; kx++)
+        {
+            float w = weights[ky * KSIZE + kx];
+            for(int c = 0 ; c < CHANNELS ; c++)
+            {
+                sum[c] += w * tile[localRow + ky][(localCol + kx) * CHANNELS + c];
+            }
+        }
+    }
+
+    int outOffset = (row * width + col) * CHANNELS;
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pOut[outOffset + c] = convert_uchar_sat_rte(sum[c] * scale + bias);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Horizontal pass: pTmp = pIn convolved with the KSIZE row weights
+__kernel void convolveRows(__global const uchar *pIn , __global float *pTmp , __constant float *weights , int width , int height)
+{
+    __local uchar tile[TILE_H][(TILE_W + 2 * RADIUS) * CHANNELS];
+
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+    int originX = get_group_id(0) * TILE_W - RADIUS;
+    int row = get_global_id(1);
+    int rowOffset = min(row , height - 1) * width;
+
+    for(int tx = localCol ; tx < TILE_W + 2 * RADIUS ; tx += TILE_W)
+    {
+        int x = originX + tx;
+        int valid = inside(x , width);
+        int offset = (rowOffset + border_coord(x , width)) * CHANNELS;
+
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            tile[localRow][tx * CHANNELS + c] = valid ? pIn[offset + c] : 0;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int col = get_global_id(0);
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    for(int kx = 0 ; kx < KSIZE ; kx++)
+    {
+        float w = weights[kx];
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            sum[c] += w * tile[localRow][(localCol + kx) * CHANNELS + c];
+        }
+    }
+
+    int outOffset = (row * width + col) * CHANNELS;
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pTmp[outOffset + c] = sum[c];
+    }
+}
+
+// Vertical pass: pOut = pTmp convolved with the KSIZE column weights , then scaled , biased and saturated
+__kernel void convolveCols(__global const float *pTmp , __global uchar *pOut , __constant float *weights ,
+                           int width , int height , float scale , float bias)
+{
+    __local float tile[TILE_H + 2 * RADIUS][TILE_W * CHANNELS];
+
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+    int originY = get_group_id(1) * TILE_H - RADIUS;
+    int col = get_global_id(0);
+    int colOffset = min(col , width - 1) * CHANNELS;
+
+    for(int ty = localRow ; ty < TILE_H + 2 * RADIUS ; ty += TILE_H)
+    {
+        int y = originY + ty;
+        int valid = inside(y , height);
+        int offset = border_coord(y , height) * width * CHANNELS + colOffset;
+
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            tile[ty][localCol * CHANNELS + c] = valid ? pTmp[offset + c] : 0.0f;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int row = get_global_id(1);
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    for(int ky = 0 ; ky < KSIZE ; ky++)
+    {
+        float w = weights[ky];
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            sum[c] += w * tile[localRow + ky][localCol * CHANNELS + c];
+        }
+    }
+
+    int outOffset = (row * width + col) * CHANNELS;
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pOut[outOffset + c] = convert_uchar_sat_rte(sum[c] * scale + bias);
+    }
+}
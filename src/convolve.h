@@ -0,0 +1,74 @@
+/*
+
+2D Convolution
+--------------
+
+1. blurKernel (specialize.cl) only averages a box. This module convolves interleaved 8-bit images (1 to 4 channels , all in one pass)
+   with any odd K x K filter up to CONV_MAX_SIZE: Gaussian , Sobel and Scharr edges , sharpening , or user supplied weights.
+2. A filter is turned into a conv_plan once. The plan uploads the weights to a buffer that the kernels read as __constant memory.
+3. conv_plan_create checks whether the weights are an outer product of a column and a row (rank 1 , e.g. box , Gaussian , Sobel).
+   A separable K x K filter runs as a row pass and a column pass: 2K multiplies per pixel instead of K * K.
+   The column pass relies on the queue being in-order , like every queue in these examples.
+4. Output = saturate(round(sum * scale + bias)). Edge filters use the bias to map 0 to mid gray.
+5. Border modes: clamp repeats the edge pixel , mirror reflects around it , zero reads 0 outside the image.
+6. The kernels in convolve.cl are specialized on the filter size , channel count and border mode with -D options.
+
+*/
+
+#ifndef CONVOLVE_H
+#define CONVOLVE_H
+
+#include "kernel_cache.h"
+
+#define CONVOLVE_PROGRAM "convolve.cl"
+#define CONV_MAX_SIZE 31
+#define CONV_TILE 16
+
+typedef enum
+{
+    BORDER_CLAMP,
+    BORDER_MIRROR,
+    BORDER_ZERO
+} conv_border;
+
+typedef struct
+{
+    int size;
+    float weights[CONV_MAX_SIZE * CONV_MAX_SIZE];       // size x size , row major
+    float scale;
+    float bias;
+} conv_filter;
+
+typedef struct
+{
+    cl_context context;
+    conv_filter filter;
+    int separable;
+    float row_weights[CONV_MAX_SIZE];
+    float col_weights[CONV_MAX_SIZE];
+
+    cl_mem weights_buff;        // size x size weights , or the row weights of a separable filter
+    cl_mem col_buff;            // column weights of a separable filter
+    cl_mem scratch;             // float intermediate image of the separable path , grown on demand
+    size_t scratch_bytes;
+} conv_plan;
+
+// Filter builders. They return 0 , or -1 when the size is even or larger than CONV_MAX_SIZE.
+int conv_filter_custom(conv_filter *filter , int size , const float *weights , float scale , float bias);
+int conv_filter_box(conv_filter *filter , int size);
+int conv_filter_gaussian(conv_filter *filter , int size , float sigma);
+void conv_filter_sobel(conv_filter *filter , int vertical);
+void conv_filter_scharr(conv_filter *filter , int vertical);
+void conv_filter_sharpen(conv_filter *filter);
+
+// Splits weights into col (size) x row (size) when the filter is separable. Returns 1 when it is.
+int conv_filter_separate(const conv_filter *filter , float *col_weights , float *row_weights);
+
+// allow_separable = 0 forces the single pass 2D kernel (for comparisons)
+cl_int conv_plan_create(conv_plan *plan , cl_context context , const conv_filter *filter , int allow_separable);
+void conv_plan_release(conv_plan *plan);
+
+cl_int launch_convolve(kernel_cache *cache , cl_command_queue queue , conv_plan *plan , cl_mem in , cl_mem out ,
+                       int width , int height , int channels , conv_border border , cl_event *event);
+
+#endif
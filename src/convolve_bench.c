@@ -0,0 +1,286 @@
+/*
+
+Convolution Benchmark
+---------------------
+
+1. Checks launch_convolve against a direct C convolution for 1 , 3 and 4 channels , every border mode , separable and non separable
+   filters , on an image whose sizes are not multiples of the tile. Results may differ by one level where the device rounds differently.
+2. Times Gaussian filters of growing size on a 1920x1080 RGB image with the single pass 2D kernel and the separable path ,
+   then the 3x3 edge and sharpen filters. Throughput is reported in megapixels per second.
+3. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 convolve_bench.c convolve.c bench_common.c kernel_cache.c -o convolve_bench -lOpenCL -lm
+
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_common.h"
+#include "convolve.h"
+
+#define CHECK_WIDTH 333
+#define CHECK_HEIGHT 211
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+#define IMAGE_CHANNELS 3
+#define NUM_ITERATIONS 10
+
+static const char *border_names[] = {"clamp" , "mirror" , "zero"};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Same border rules as convolve.cl. Returns -1 for a zero border pixel.
+static int reference_coord(int i , int n , conv_border border)
+{
+    if(border == BORDER_ZERO)
+    {
+        return (i >= 0 && i < n) ? i : -1;
+    }
+    if(border == BORDER_MIRROR)
+    {
+        i = i < 0 ? -i : i;
+        i = i >= n ? 2 * n - 2 - i : i;
+    }
+    return i < 0 ? 0 : i >= n ? n - 1 : i;
+}
+
+static void reference_convolve(const unsigned char *pIn , unsigned char *pOut , int width , int height , int channels ,
+                               const conv_filter *filter , conv_border border)
+{
+    int radius = filter->size / 2;
+
+    for(int row = 0 ; row < height ; row++)
+    {
+        for(int col = 0 ; col < width ; col++)
+        {
+            for(int c = 0 ; c < channels ; c++)
+            {
+                double sum = 0.0;
+                for(int ky = 0 ; ky < filter->size ; ky++)
+                {
+                    int y = reference_coord(row + ky - radius , height , border);
+                    for(int kx = 0 ; kx < filter->size ; kx++)
+                    {
+                        int x = reference_coord(col + kx - radius , width , border);
+                        if(x >= 0 && y >= 0)
+                        {
+                            sum += filter->weights[ky * filter->size + kx] * pIn[(y * width + x) * channels + c];
+                        }
+                    }
+                }
+                double value = sum * filter->scale + filter->bias;
+                value = value < 0.0 ? 0.0 : value > 255.0 ? 255.0 : value;
+                pOut[(row * width + col) * channels + c] = (unsigned char)lrint(value);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int check_filter(kernel_cache *cache , cl_command_queue queue , cl_context context , const char *name ,
+                        const conv_filter *filter , const unsigned char *image)
+{
+    size_t max_bytes = (size_t)CHECK_WIDTH * CHECK_HEIGHT * 4;
+    unsigned char *expected = (unsigned char*)malloc(max_bytes);
+    unsigned char *result = (unsigned char*)malloc(max_bytes);
+    cl_mem in_buff , out_buff;
+    cl_int err;
+    int failures = 0;
+
+    in_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , max_bytes , (void*)image , &err);
+    out_buff = clCreateBuffer(context , CL_MEM_WRITE_ONLY , max_bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the check buffers");
+        exit(1);
+    }
+
+    for(int separable = 0 ; separable < 2 ; separable++)
+    {
+        conv_plan plan;
+        if(conv_plan_create(&plan , context , filter , separable) != CL_SUCCESS)
+        {
+            perror("Couldn't create the convolution plan");
+            exit(1);
+        }
+        if(separable && !plan.separable)
+        {
+            conv_plan_release(&plan);
+            continue;
+        }
+
+        for(int channels = 1 ; channels <= 4 ; channels++)
+        {
+            if(channels == 2)
+            {
+                continue;
+            }
+            for(int border = BORDER_CLAMP ; border <= BORDER_ZERO ; border++)
+            {
+                size_t bytes = (size_t)CHECK_WIDTH * CHECK_HEIGHT * channels;
+                int worst = 0;
+
+                reference_convolve(image , expected , CHECK_WIDTH , CHECK_HEIGHT , channels , filter , (conv_border)border);
+                err = launch_convolve(cache , queue , &plan , in_buff , out_buff , CHECK_WIDTH , CHECK_HEIGHT , channels ,
+                                      (conv_border)border , NULL);
+                if(err == CL_SUCCESS)
+                {
+                    err = clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+                }
+
+                for(size_t i = 0 ; i < bytes && err == CL_SUCCESS ; i++)
+                {
+                    int diff = abs((int)expected[i] - (int)result[i]);
+                    worst = diff > worst ? diff : worst;
+                }
+
+                if(err != CL_SUCCESS || worst > 1)
+                {
+                    printf("FAIL %-10s %-9s %d channel(s) %-6s: %s %d\n", name , plan.separable ? "separable" : "2D" , channels ,
+                           border_names[border] , err != CL_SUCCESS ? "error" : "max difference" , err != CL_SUCCESS ? err : worst);
+                    failures++;
+                }
+            }
+        }
+
+        conv_plan_release(&plan);
+    }
+
+    printf("%-12s %dx%d %s\n", name , filter->size , filter->size , failures ? "FAILED" : "ok");
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+    free(expected);
+    free(result);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double time_filter(kernel_cache *cache , cl_command_queue queue , conv_plan *plan , cl_mem in , cl_mem out)
+{
+    // Warm-up launch builds the variant
+    launch_convolve(cache , queue , plan , in , out , IMAGE_WIDTH , IMAGE_HEIGHT , IMAGE_CHANNELS , BORDER_CLAMP , NULL);
+    clFinish(queue);
+
+    double start = bench_now_ms();
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        if(launch_convolve(cache , queue , plan , in , out , IMAGE_WIDTH , IMAGE_HEIGHT , IMAGE_CHANNELS , BORDER_CLAMP , NULL) != CL_SUCCESS)
+        {
+            printf("Couldn't enqueue the convolution\n");
+            exit(1);
+        }
+    }
+    clFinish(queue);
+    double ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    return (double)IMAGE_WIDTH * IMAGE_HEIGHT / (ms * 1.0e3);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    conv_filter filter;
+    int failures = 0;
+
+    bench_init(&bench , 0);
+
+    // Correctness
+    unsigned char *check_image = (unsigned char*)malloc((size_t)CHECK_WIDTH * CHECK_HEIGHT * 4);
+    for(size_t i = 0 ; i < (size_t)CHECK_WIDTH * CHECK_HEIGHT * 4 ; i++)
+    {
+        check_image[i] = (unsigned char)(rand() & 0xFF);
+    }
+
+    float random_weights[7 * 7];
+    for(int i = 0 ; i < 7 * 7 ; i++)
+    {
+        random_weights[i] = (rand() % 201 - 100) / 1000.0f;
+    }
+
+    conv_filter_gaussian(&filter , 5 , 1.2f);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "gaussian" , &filter , check_image);
+    conv_filter_sobel(&filter , 0);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "sobel_x" , &filter , check_image);
+    conv_filter_scharr(&filter , 1);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "scharr_y" , &filter , check_image);
+    conv_filter_sharpen(&filter);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "sharpen" , &filter , check_image);
+    conv_filter_custom(&filter , 7 , random_weights , 1.0f , 128.0f);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "random" , &filter , check_image);
+    conv_filter_box(&filter , 31);
+    failures += check_filter(&bench.cache , bench.queue , bench.context , "box" , &filter , check_image);
+
+    // Throughput
+    size_t image_bytes = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT * IMAGE_CHANNELS;
+    unsigned char *image = (unsigned char*)malloc(image_bytes);
+    for(size_t i = 0 ; i < image_bytes ; i++)
+    {
+        image[i] = (unsigned char)(rand() & 0xFF);
+    }
+
+    cl_mem image_in = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , image_bytes , image , &err);
+    cl_mem image_out = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , image_bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the image buffers");
+        exit(1);
+    }
+
+    printf("\nGaussian , %dx%d , %d channels , MP/s\n", IMAGE_WIDTH , IMAGE_HEIGHT , IMAGE_CHANNELS);
+    printf("%6s %12s %12s %9s\n", "size" , "2D" , "separable" , "speedup");
+    for(int size = 3 ; size <= CONV_MAX_SIZE ; size += (size < 9 ? 2 : 6))
+    {
+        conv_plan direct , split;
+
+        conv_filter_gaussian(&filter , size , size / 4.0f);
+        conv_plan_create(&direct , bench.context , &filter , 0);
+        conv_plan_create(&split , bench.context , &filter , 1);
+
+        double direct_mps = time_filter(&bench.cache , bench.queue , &direct , image_in , image_out);
+        double split_mps = time_filter(&bench.cache , bench.queue , &split , image_in , image_out);
+        printf("%6d %12.1f %12.1f %8.2fx\n", size , direct_mps , split_mps , split_mps / direct_mps);
+
+        conv_plan_release(&direct);
+        conv_plan_release(&split);
+    }
+
+    printf("\n3x3 filters , MP/s\n");
+    for(int which = 0 ; which < 3 ; which++)
+    {
+        conv_plan plan;
+        const char *name = which == 0 ? "sobel_x" : which == 1 ? "scharr_x" : "sharpen";
+
+        if(which == 0)
+        {
+            conv_filter_sobel(&filter , 0);
+        }
+        else if(which == 1)
+        {
+            conv_filter_scharr(&filter , 0);
+        }
+        else
+        {
+            conv_filter_sharpen(&filter);
+        }
+
+        conv_plan_create(&plan , bench.context , &filter , 1);
+        printf("%-10s %-9s %12.1f\n", name , plan.separable ? "separable" : "2D" ,
+               time_filter(&bench.cache , bench.queue , &plan , image_in , image_out));
+        conv_plan_release(&plan);
+    }
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    free(check_image);
+    free(image);
+    clReleaseMemObject(image_in);
+    clReleaseMemObject(image_out);
+    bench_release(&bench);
+
+    return failures;
+}
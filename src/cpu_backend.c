@@ -0,0 +1,410 @@
+#include <immintrin.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_backend.h"
+
+#define ELEMENT_GRAIN 16384
+
+typedef void (*binary_func)(const float *a , const float *b , float *result , size_t n);
+typedef float (*dot_func)(const float *a , const float *b , size_t n);
+typedef void (*gray_func)(unsigned char *pOut , const unsigned char *pIn , size_t num_pixels);
+typedef void (*accumulate_func)(int *sum , const int *row , size_t n , int sign);
+
+typedef struct
+{
+    const char *isa;
+    binary_func add;
+    binary_func mult;
+    binary_func sub;
+    dot_func dot;
+    gray_func gray;
+    accumulate_func accumulate;
+} cpu_kernels;
+
+static cpu_kernels kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+/*
+    1. Each operation has a scalar , an AVX2 and an AVX-512 version. The target attribute lets one translation unit hold all three
+       without compiling the whole file for the newest instruction set.
+    2. The gray conversion and the blur accumulation are written once as inline C and compiled again inside target functions,
+       where the compiler vectorizes them for that instruction set.
+*/
+
+//----------------------------------------------------------------------------------------------------------------------------------
+#define DEFINE_ELEMENTWISE(name , scalar_op , avx2_op , avx512_op)                                                           \
+static void name##_scalar(const float *a , const float *b , float *result , size_t n)                                          \
+{                                                                                                                              \
+    for(size_t i = 0 ; i < n ; i++)                                                                                            \
+    {                                                                                                                          \
+        result[i] = a[i] scalar_op b[i];                                                                                       \
+    }                                                                                                                          \
+}                                                                                                                              \
+                                                                                                                               \
+__attribute__((target("avx2")))                                                                                                \
+static void name##_avx2(const float *a , const float *b , float *result , size_t n)                                            \
+{                                                                                                                              \
+    size_t i = 0;                                                                                                              \
+    for(; i + 8 <= n ; i += 8)                                                                                                 \
+    {                                                                                                                          \
+        _mm256_storeu_ps(result + i , avx2_op(_mm256_loadu_ps(a + i) , _mm256_loadu_ps(b + i)));                               \
+    }                                                                                                                          \
+    for(; i < n ; i++)                                                                                                         \
+    {                                                                                                                          \
+        result[i] = a[i] scalar_op b[i];                                                                                       \
+    }                                                                                                                          \
+}                                                                                                                              \
+                                                                                                                               \
+__attribute__((target("avx512f")))                                                                                             \
+static void name##_avx512(const float *a , const float *b , float *result , size_t n)                                          \
+{                                                                                                                              \
+    size_t i = 0;                                                                                                              \
+    for(; i + 16 <= n ; i += 16)                                                                                               \
+    {                                                                                                                          \
+        _mm512_storeu_ps(result + i , avx512_op(_mm512_loadu_ps(a + i) , _mm512_loadu_ps(b + i)));                             \
+    }                                                                                                                          \
+    if(i < n)                                                                                                                  \
+    {                                                                                                                          \
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);                                                                     \
+        __m512 va = _mm512_maskz_loadu_ps(mask , a + i);                                                                       \
+        __m512 vb = _mm512_maskz_loadu_ps(mask , b + i);                                                                       \
+        _mm512_mask_storeu_ps(result + i , mask , avx512_op(va , vb));                                                         \
+    }                                                                                                                          \
+}
+
+DEFINE_ELEMENTWISE(add , + , _mm256_add_ps , _mm512_add_ps)
+DEFINE_ELEMENTWISE(mult , * , _mm256_mul_ps , _mm512_mul_ps)
+DEFINE_ELEMENTWISE(sub , - , _mm256_sub_ps , _mm512_sub_ps)
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static float dot_scalar(const float *a , const float *b , size_t n)
+{
+    float sum = 0.0f;
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float *a , const float *b , size_t n)
+{
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 8 <= n ; i += 8)
+    {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i) , _mm256_loadu_ps(b + i) , acc);
+    }
+
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc) , _mm256_extractf128_ps(acc , 1));
+    half = _mm_add_ps(half , _mm_movehl_ps(half , half));
+    half = _mm_add_ss(half , _mm_shuffle_ps(half , half , 1));
+    float sum = _mm_cvtss_f32(half);
+
+    for(; i < n ; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(const float *a , const float *b , size_t n)
+{
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 16 <= n ; i += 16)
+    {
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i) , _mm512_loadu_ps(b + i) , acc);
+    }
+    if(i < n)
+    {
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask , a + i) , _mm512_maskz_loadu_ps(mask , b + i) , acc);
+    }
+    return _mm512_reduce_add_ps(acc);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static inline void gray_body(unsigned char *pOut , const unsigned char *pIn , size_t num_pixels)
+{
+    for(size_t i = 0 ; i < num_pixels ; i++)
+    {
+        unsigned char r = pIn[i * 3];
+        unsigned char g = pIn[i * 3 + 1];
+        unsigned char b = pIn[i * 3 + 2];
+        pOut[i] = (unsigned char)(0.299f * r + 0.587f * g + 0.114f * b);
+    }
+}
+
+static inline void accumulate_body(int *sum , const int *row , size_t n , int sign)
+{
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        sum[i] += sign * row[i];
+    }
+}
+
+static void gray_scalar(unsigned char *pOut , const unsigned char *pIn , size_t num_pixels) { gray_body(pOut , pIn , num_pixels); }
+static void accumulate_scalar(int *sum , const int *row , size_t n , int sign) { accumulate_body(sum , row , n , sign); }
+
+__attribute__((target("avx2")))
+static void gray_avx2(unsigned char *pOut , const unsigned char *pIn , size_t num_pixels) { gray_body(pOut , pIn , num_pixels); }
+__attribute__((target("avx2")))
+static void accumulate_avx2(int *sum , const int *row , size_t n , int sign) { accumulate_body(sum , row , n , sign); }
+
+__attribute__((target("avx512f,avx512bw")))
+static void gray_avx512(unsigned char *pOut , const unsigned char *pIn , size_t num_pixels) { gray_body(pOut , pIn , num_pixels); }
+__attribute__((target("avx512f,avx512bw")))
+static void accumulate_avx512(int *sum , const int *row , size_t n , int sign) { accumulate_body(sum , row , n , sign); }
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void select_kernels(void)
+{
+    const char *limit = getenv("CPU_BACKEND_ISA");
+    int allow_avx512 = (limit == NULL || strcmp(limit , "avx512") == 0);
+    int allow_avx2 = allow_avx512 || (limit != NULL && strcmp(limit , "avx2") == 0);
+
+    __builtin_cpu_init();
+
+    if(allow_avx512 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        kernels = (cpu_kernels){"avx512" , add_avx512 , mult_avx512 , sub_avx512 , dot_avx512 , gray_avx512 , accumulate_avx512};
+    }
+    else if(allow_avx2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        kernels = (cpu_kernels){"avx2" , add_avx2 , mult_avx2 , sub_avx2 , dot_avx2 , gray_avx2 , accumulate_avx2};
+    }
+    else
+    {
+        kernels = (cpu_kernels){"scalar" , add_scalar , mult_scalar , sub_scalar , dot_scalar , gray_scalar , accumulate_scalar};
+    }
+}
+
+static const cpu_kernels* get_kernels(void)
+{
+    pthread_once(&kernels_once , select_kernels);
+    return &kernels;
+}
+
+const char* cpu_backend_isa(void)
+{
+    return get_kernels()->isa;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+    binary_func func;
+    const float *a;
+    const float *b;
+    float *result;
+} binary_task;
+
+static void binary_range(size_t begin , size_t end , void *arg)
+{
+    binary_task *task = (binary_task*)arg;
+    task->func(task->a + begin , task->b + begin , task->result + begin , end - begin);
+}
+
+static void run_binary(thread_pool *pool , binary_func func , const float *a , const float *b , float *result , size_t n)
+{
+    binary_task task = {func , a , b , result};
+    thread_pool_parallel_for(pool , n , ELEMENT_GRAIN , binary_range , &task);
+}
+
+void cpu_add_arrays(thread_pool *pool , const float *A , const float *B , float *C , size_t n)
+{
+    run_binary(pool , get_kernels()->add , A , B , C , n);
+}
+
+void cpu_mult(thread_pool *pool , const float *a , const float *b , float *result , size_t n)
+{
+    run_binary(pool , get_kernels()->mult , a , b , result , n);
+}
+
+void cpu_add(thread_pool *pool , const float *a , const float *b , float *result , size_t n)
+{
+    run_binary(pool , get_kernels()->add , a , b , result , n);
+}
+
+void cpu_sub(thread_pool *pool , const float *a , const float *b , float *result , size_t n)
+{
+    run_binary(pool , get_kernels()->sub , a , b , result , n);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+    dot_func dot;
+    const float *matrix;
+    const float *vector;
+    float *result;
+    size_t cols;
+} mat_vec_task;
+
+static void mat_vec_range(size_t begin , size_t end , void *arg)
+{
+    mat_vec_task *task = (mat_vec_task*)arg;
+    for(size_t row = begin ; row < end ; row++)
+    {
+        task->result[row] = task->dot(task->matrix + row * task->cols , task->vector , task->cols);
+    }
+}
+
+void cpu_mat_vec_mult(thread_pool *pool , const float *matrix , const float *vector , float *result , size_t rows , size_t cols)
+{
+    mat_vec_task task = {get_kernels()->dot , matrix , vector , result , cols};
+    size_t grain = ELEMENT_GRAIN / (cols ? cols : 1);
+    thread_pool_parallel_for(pool , rows , grain ? grain : 1 , mat_vec_range , &task);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+    gray_func gray;
+    unsigned char *pOut;
+    const unsigned char *pIn;
+    int width;
+} gray_task;
+
+static void gray_range(size_t begin , size_t end , void *arg)
+{
+    gray_task *task = (gray_task*)arg;
+    size_t offset = begin * task->width;
+    task->gray(task->pOut + offset , task->pIn + offset * 3 , (end - begin) * task->width);
+}
+
+void cpu_rgb_to_gray(thread_pool *pool , unsigned char *pOut , const unsigned char *pIn , int width , int height)
+{
+    gray_task task = {get_kernels()->gray , pOut , pIn , width};
+    size_t grain = ELEMENT_GRAIN / (width ? width : 1);
+    thread_pool_parallel_for(pool , height , grain ? grain : 1 , gray_range , &task);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/*
+    1. The clipped box window is a rectangle, so the blur is separable: horizontal window sums per row, then a running
+       vertical sum of those rows. Each output pixel costs O(1) instead of O(radius^2).
+    2. The pixel count is the product of the clipped window width and height, so the integer result matches blurKernel exactly.
+    3. Each task recomputes the horizontal sums of the radius rows above and below its own rows.
+*/
+typedef struct
+{
+    accumulate_func accumulate;
+    const unsigned char *pIn;
+    unsigned char *pOut;
+    int width;
+    int height;
+    int radius;
+} blur_task;
+
+static void blur_horizontal(const unsigned char *row , int *sums , int width , int radius)
+{
+    int window[3] = {0 , 0 , 0};
+
+    for(int x = 0 ; x < radius && x < width ; x++)
+    {
+        for(int c = 0 ; c < 3 ; c++)
+        {
+            window[c] += row[x * 3 + c];
+        }
+    }
+
+    for(int x = 0 ; x < width ; x++)
+    {
+        int enter = x + radius;
+        int leave = x - radius - 1;
+        for(int c = 0 ; c < 3 ; c++)
+        {
+            if(enter < width)
+            {
+                window[c] += row[enter * 3 + c];
+            }
+            if(leave >= 0)
+            {
+                window[c] -= row[leave * 3 + c];
+            }
+            sums[x * 3 + c] = window[c];
+        }
+    }
+}
+
+static void blur_range(size_t begin , size_t end , void *arg)
+{
+    blur_task *task = (blur_task*)arg;
+    int width = task->width;
+    int height = task->height;
+    int radius = task->radius;
+    size_t row_len = (size_t)width * 3;
+
+    int first = (int)begin - radius < 0 ? 0 : (int)begin - radius;
+    int last = (int)end + radius > height ? height : (int)end + radius;
+
+    int *rows = (int*)malloc(sizeof(int) * row_len * (last - first));
+    int *vsum = (int*)calloc(row_len , sizeof(int));
+    int *hcount = (int*)malloc(sizeof(int) * width);
+
+    for(int y = first ; y < last ; y++)
+    {
+        blur_horizontal(task->pIn + y * row_len , rows + (y - first) * row_len , width , radius);
+    }
+
+    for(int x = 0 ; x < width ; x++)
+    {
+        int lo = x - radius < 0 ? 0 : x - radius;
+        int hi = x + radius >= width ? width - 1 : x + radius;
+        hcount[x] = hi - lo + 1;
+    }
+
+    // Prime the vertical window for the first output row, minus the row that enters on the first step
+    for(int y = first ; y < (int)begin + radius && y < height ; y++)
+    {
+        task->accumulate(vsum , rows + (y - first) * row_len , row_len , 1);
+    }
+
+    for(int y = (int)begin ; y < (int)end ; y++)
+    {
+        int enter = y + radius;
+        int leave = y - radius - 1;
+        if(enter < height)
+        {
+            task->accumulate(vsum , rows + (enter - first) * row_len , row_len , 1);
+        }
+        if(leave >= first)
+        {
+            task->accumulate(vsum , rows + (leave - first) * row_len , row_len , -1);
+        }
+
+        int lo = y - radius < 0 ? 0 : y - radius;
+        int hi = y + radius >= height ? height - 1 : y + radius;
+        int vcount = hi - lo + 1;
+
+        unsigned char *out = task->pOut + y * row_len;
+        for(int x = 0 ; x < width ; x++)
+        {
+            int pixels = hcount[x] * vcount;
+            out[x * 3] = vsum[x * 3] / pixels;
+            out[x * 3 + 1] = vsum[x * 3 + 1] / pixels;
+            out[x * 3 + 2] = vsum[x * 3 + 2] / pixels;
+        }
+    }
+
+    free(rows);
+    free(vsum);
+    free(hcount);
+}
+
+void cpu_blur(thread_pool *pool , const unsigned char *pIn , unsigned char *pOut , int width , int height , int radius)
+{
+    blur_task task = {get_kernels()->accumulate , pIn , pOut , width , height , radius};
+
+    // Tall enough chunks that the 2 * radius halo rows stay a small fraction of the work
+    size_t grain = (size_t)(8 * radius + 16);
+    thread_pool_parallel_for(pool , height , grain , blur_range , &task);
+}
@@ -0,0 +1,40 @@
+/*
+
+Native CPU Backend
+------------------
+
+1. Host implementations of the kernels in kernel_compute.cl (add_arrays) , kernel_search.cl (mult , add , sub) , mat_vec.cl (mat_vec_mult)
+   and the image kernels (rgbToGrayScale , blurKernel). Arguments follow the kernel argument order , plus the problem size.
+2. Loops run on a work-stealing thread_pool. The vector instruction set is picked at runtime from what the CPU supports:
+   AVX-512 , then AVX2 + FMA , then plain C.
+3. Setting the environment variable CPU_BACKEND_ISA to "avx512" , "avx2" or "scalar" limits the choice, which is how the
+   parity tests exercise every path on one machine.
+4. No OpenCL platform is needed , so these functions work on hosts without an ICD.
+
+*/
+
+#ifndef CPU_BACKEND_H
+#define CPU_BACKEND_H
+
+#include <stddef.h>
+
+#include "thread_pool.h"
+
+// Name of the instruction set selected at runtime: "avx512" , "avx2" or "scalar"
+const char* cpu_backend_isa(void);
+
+void cpu_add_arrays(thread_pool *pool , const float *A , const float *B , float *C , size_t n);
+void cpu_mult(thread_pool *pool , const float *a , const float *b , float *result , size_t n);
+void cpu_add(thread_pool *pool , const float *a , const float *b , float *result , size_t n);
+void cpu_sub(thread_pool *pool , const float *a , const float *b , float *result , size_t n);
+
+// result[i] = dot(row i of matrix , vector) for a row-major rows x cols matrix
+void cpu_mat_vec_mult(thread_pool *pool , const float *matrix , const float *vector , float *result , size_t rows , size_t cols);
+
+// Interleaved 8-bit RGB to 8-bit gray , same weights as rgbToGrayScale
+void cpu_rgb_to_gray(thread_pool *pool , unsigned char *pOut , const unsigned char *pIn , int width , int height);
+
+// Box blur of interleaved 8-bit RGB with a (2 * radius + 1)^2 window clipped at the borders , same result as blurKernel
+void cpu_blur(thread_pool *pool , const unsigned char *pIn , unsigned char *pOut , int width , int height , int radius);
+
+#endif
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+#include "demosaic.h"
+
+// Column and row parity of the red samples for each pattern
+static const int red_x[] = {0 , 1 , 1 , 0};
+static const int red_y[] = {0 , 1 , 0 , 1};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+const char* cfa_pattern_name(cfa_pattern pattern)
+{
+    switch(pattern)
+    {
+        case CFA_RGGB: return "RGGB";
+        case CFA_BGGR: return "BGGR";
+        case CFA_GRBG: return "GRBG";
+        case CFA_GBRG: return "GBRG";
+        default: return "?";
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int launch_demosaic(kernel_cache *cache , cl_command_queue queue , cl_mem raw , cl_mem out , int width , int height , int bit_depth ,
+                       cfa_pattern pattern , demosaic_method method , int gray_output , cl_event *event)
+{
+    char options[128];
+    cl_kernel kernel;
+    cl_int err;
+
+    if(bit_depth < 8 || bit_depth > 16 || pattern < CFA_RGGB || pattern > CFA_GBRG)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    snprintf(options , sizeof(options) , "-DRED_X=%d -DRED_Y=%d -DMETHOD=%d -DBIT_DEPTH=%d -DTILE=%d%s",
+             red_x[pattern] , red_y[pattern] , (int)method , bit_depth , DEMOSAIC_TILE , gray_output ? " -DGRAY_OUTPUT" : "");
+    kernel = kernel_cache_get(cache , DEMOSAIC_PROGRAM , "demosaic" , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &raw);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &height);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {DEMOSAIC_TILE , DEMOSAIC_TILE};
+    size_t global_size[2] = {(width + DEMOSAIC_TILE - 1) / DEMOSAIC_TILE * DEMOSAIC_TILE ,
+                             (height + DEMOSAIC_TILE - 1) / DEMOSAIC_TILE * DEMOSAIC_TILE};
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
@@ -0,0 +1,149 @@
+/*
+    Bayer demosaicing of 16-bit RAW frames into 8-bit interleaved RGB (the input format of rgbToGrayScale and blurKernel) ,
+    or straight into 8-bit gray. The macros below are supplied as -D build options by launch_demosaic (demosaic.c).
+
+    RED_X , RED_Y   column and row parity of the red pixels: RGGB 0 0 , BGGR 1 1 , GRBG 1 0 , GBRG 0 1
+    METHOD          0 bilinear , 1 Malvar-He-Cutler
+    BIT_DEPTH       significant bits of the RAW samples , 8 to 16. The output is scaled down to 8 bits.
+    GRAY_OUTPUT     when defined , writes 0.299 R + 0.587 G + 0.114 B like rgbToGrayScale instead of RGB , so the RGB frame is never stored
+    TILE            work-group edge (default 16). The kernel must be launched with a TILE x TILE local size.
+
+    1. Bilinear averages the nearest samples of the missing colour.
+    2. Malvar-He-Cutler (2004) adds a correction from the Laplacian of the colour that was sampled at the pixel , so an edge in one channel
+       sharpens the interpolation of the others. It uses a 5x5 neighbourhood and costs about twice as much as bilinear.
+    3. The work-group loads its tile with a halo into local memory. Borders are mirrored without repeating the edge sample
+       (... 2 1 | 0 1 2 ...) , which keeps the colour of every mirrored sample the same as in the pattern.
+*/
+
+#ifndef RED_X
+#define RED_X 0
+#endif
+
+#ifndef RED_Y
+#define RED_Y 0
+#endif
+
+#ifndef METHOD
+#define METHOD 0
+#endif
+
+#ifndef BIT_DEPTH
+#define BIT_DEPTH 12
+#endif
+
+#ifndef TILE
+#define TILE 16
+#endif
+
+#if METHOD == 1
+#define HALO 2
+#else
+#define HALO 1
+#endif
+
+inline int mirror(int i , int n)
+{
+    if(i < 0)
+    {
+        i = -i;
+    }
+    if(i >= n)
+    {
+        i = 2 * n - 2 - i;
+    }
+    return clamp(i , 0 , n - 1);
+}
+
+__kernel void demosaic(__global const ushort *pRaw , __global uchar *pOut , int width , int height)
+{
+    __local float tile[TILE + 2 * HALO][TILE + 2 * HALO];
+
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+    int originX = get_group_id(0) * TILE - HALO;
+    int originY = get_group_id(1) * TILE - HALO;
+
+    for(int ty = localRow ; ty < TILE + 2 * HALO ; ty += TILE)
+    {
+        int rowOffset = mirror(originY + ty , height) * width;
+        for(int tx = localCol ; tx < TILE + 2 * HALO ; tx += TILE)
+        {
+            tile[ty][tx] = pRaw[rowOffset + mirror(originX + tx , width)];
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+#define P(dx , dy) tile[localRow + HALO + (dy)][localCol + HALO + (dx)]
+
+    int redRow = (row & 1) == RED_Y;
+    int redCol = (col & 1) == RED_X;
+    float centre = P(0 , 0);
+    float cross = P(-1 , 0) + P(1 , 0) + P(0 , -1) + P(0 , 1);
+    float diagonal = P(-1 , -1) + P(1 , -1) + P(-1 , 1) + P(1 , 1);
+    float r , g , b;
+
+#if METHOD == 1
+    float farRow = P(-2 , 0) + P(2 , 0);
+    float farCol = P(0 , -2) + P(0 , 2);
+
+    // Green at red / blue , the other of red / blue , and red / blue at green from its row or column neighbours
+    float green = (4.0f * centre + 2.0f * cross - farRow - farCol) * 0.125f;
+    float opposite = (6.0f * centre + 2.0f * diagonal - 1.5f * (farRow + farCol)) * 0.125f;
+    float alongRow = (5.0f * centre + 4.0f * (P(-1 , 0) + P(1 , 0)) - farRow - diagonal + 0.5f * farCol) * 0.125f;
+    float alongCol = (5.0f * centre + 4.0f * (P(0 , -1) + P(0 , 1)) - farCol - diagonal + 0.5f * farRow) * 0.125f;
+#else
+    float green = cross * 0.25f;
+    float opposite = diagonal * 0.25f;
+    float alongRow = (P(-1 , 0) + P(1 , 0)) * 0.5f;
+    float alongCol = (P(0 , -1) + P(0 , 1)) * 0.5f;
+#endif
+
+    if(redRow && redCol)
+    {
+        r = centre;
+        g = green;
+        b = opposite;
+    }
+    else if(!redRow && !redCol)
+    {
+        r = opposite;
+        g = green;
+        b = centre;
+    }
+    else if(redRow)
+    {
+        // Green in a red row: red neighbours left and right , blue above and below
+        r = alongRow;
+        g = centre;
+        b = alongCol;
+    }
+    else
+    {
+        r = alongCol;
+        g = centre;
+        b = alongRow;
+    }
+
+#undef P
+
+    const float scale = 1.0f / (1 << (BIT_DEPTH - 8));
+    uchar red = convert_uchar_sat_rte(r * scale);
+    uchar grn = convert_uchar_sat_rte(g * scale);
+    uchar blu = convert_uchar_sat_rte(b * scale);
+
+#ifdef GRAY_OUTPUT
+    pOut[row * width + col] = (uchar)(0.299f * red + 0.587f * grn + 0.114f * blu);
+#else
+    int rgbOffset = (row * width + col) * 3;
+    pOut[rgbOffset] = red;
+    pOut[rgbOffset + 1] = grn;
+    pOut[rgbOffset + 2] = blu;
+#endif
+}
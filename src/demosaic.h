@@ -0,0 +1,44 @@
+/*
+
+Bayer Demosaicing
+-----------------
+
+1. A Bayer sensor samples one colour per pixel in a repeating 2x2 pattern (CFA). launch_demosaic interpolates the two missing
+   colours of every pixel on the device , turning a RAW frame into the 8-bit interleaved RGB used by rgbToGrayScale and blurKernel.
+2. RAW samples are 16-bit (ushort) holding bit_depth significant bits , 8 to 16 (10 , 12 and 14-bit sensors are typical).
+3. DEMOSAIC_BILINEAR averages neighbours. DEMOSAIC_MHC (Malvar-He-Cutler) adds a gradient correction that keeps edges sharp
+   and avoids most colour fringes , for about twice the arithmetic.
+4. gray_output fuses the grayscale conversion: the kernel writes one gray byte per pixel instead of three RGB bytes.
+   The result is the same as demosaicing and then running rgbToGrayScale.
+
+*/
+
+#ifndef DEMOSAIC_H
+#define DEMOSAIC_H
+
+#include "kernel_cache.h"
+
+#define DEMOSAIC_PROGRAM "demosaic.cl"
+#define DEMOSAIC_TILE 16
+
+typedef enum
+{
+    CFA_RGGB,
+    CFA_BGGR,
+    CFA_GRBG,
+    CFA_GBRG
+} cfa_pattern;
+
+typedef enum
+{
+    DEMOSAIC_BILINEAR,
+    DEMOSAIC_MHC
+} demosaic_method;
+
+const char* cfa_pattern_name(cfa_pattern pattern);
+
+// raw: width x height ushort. out: width x height x 3 bytes , or width x height bytes with gray_output.
+cl_int launch_demosaic(kernel_cache *cache , cl_command_queue queue , cl_mem raw , cl_mem out , int width , int height , int bit_depth ,
+                       cfa_pattern pattern , demosaic_method method , int gray_output , cl_event *event);
+
+#endif
@@ -0,0 +1,342 @@
+/*
+
+Demosaic Benchmark
+------------------
+
+1. A synthetic RGB scene (smooth gradients , hard edged blocks and thin lines) is sampled through each CFA pattern into a RAW frame.
+2. Checks every pattern and method against a C implementation of the same interpolation (within one level) , and the fused gray
+   output against demosaic followed by rgbToGrayScale (grayscale.cl).
+3. Reports the PSNR of both methods against the original scene , so the quality gained by Malvar-He-Cutler is visible.
+4. Latency per 1920x1080 frame: kernel time from event profiling , and end to end time for upload , demosaic and read back.
+   The fused gray path reads back a third of the bytes and skips the rgbToGrayScale launch.
+5. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 demosaic_bench.c demosaic.c bench_common.c kernel_cache.c -o demosaic_bench -lOpenCL -lm
+
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "demosaic.h"
+
+#define CHECK_WIDTH 161
+#define CHECK_HEIGHT 97
+#define FRAME_WIDTH 1920
+#define FRAME_HEIGHT 1080
+#define FRAME_BIT_DEPTH 12
+#define NUM_ITERATIONS 10
+
+static const char *method_names[] = {"bilinear" , "mhc"};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Scene in [0 , 1] per channel , and its RAW samples
+static void make_scene(float *scene , unsigned short *raw , int width , int height , int bit_depth , cfa_pattern pattern)
+{
+    static const int red_x[] = {0 , 1 , 1 , 0};
+    static const int red_y[] = {0 , 1 , 0 , 1};
+    float max_value = (float)((1 << bit_depth) - 1);
+
+    for(int y = 0 ; y < height ; y++)
+    {
+        for(int x = 0 ; x < width ; x++)
+        {
+            float *p = scene + ((size_t)y * width + x) * 3;
+            p[0] = 0.5f + 0.4f * sinf(x * 0.02f);
+            p[1] = 0.5f + 0.4f * cosf(y * 0.03f);
+            p[2] = (float)(x + y) / (width + height);
+
+            // Hard edged blocks and thin lines
+            if(((x / 40) + (y / 40)) % 5 == 0)
+            {
+                p[0] = 0.9f;
+                p[1] = 0.1f;
+                p[2] = 0.2f;
+            }
+            if(x % 97 == 0 || y % 89 == 0)
+            {
+                p[0] = p[1] = p[2] = 1.0f;
+            }
+
+            int redRow = (y & 1) == red_y[pattern];
+            int redCol = (x & 1) == red_x[pattern];
+            int channel = (redRow && redCol) ? 0 : (!redRow && !redCol) ? 2 : 1;
+            raw[(size_t)y * width + x] = (unsigned short)lrintf(p[channel] * max_value);
+        }
+    }
+}
+
+static int mirror(int i , int n)
+{
+    i = i < 0 ? -i : i;
+    i = i >= n ? 2 * n - 2 - i : i;
+    return i < 0 ? 0 : i > n - 1 ? n - 1 : i;
+}
+
+static unsigned char to_byte(double v , int bit_depth)
+{
+    v = v / (1 << (bit_depth - 8));
+    v = v < 0.0 ? 0.0 : v > 255.0 ? 255.0 : v;
+    return (unsigned char)lrint(v);
+}
+
+// Same interpolation as demosaic.cl , in double precision
+static void reference_demosaic(const unsigned short *raw , unsigned char *rgb , int width , int height , int bit_depth ,
+                               cfa_pattern pattern , demosaic_method method)
+{
+    static const int red_x[] = {0 , 1 , 1 , 0};
+    static const int red_y[] = {0 , 1 , 0 , 1};
+
+    for(int y = 0 ; y < height ; y++)
+    {
+        for(int x = 0 ; x < width ; x++)
+        {
+#define P(dx , dy) ((double)raw[(size_t)mirror(y + (dy) , height) * width + mirror(x + (dx) , width)])
+            int redRow = (y & 1) == red_y[pattern];
+            int redCol = (x & 1) == red_x[pattern];
+            double centre = P(0 , 0);
+            double cross = P(-1 , 0) + P(1 , 0) + P(0 , -1) + P(0 , 1);
+            double diagonal = P(-1 , -1) + P(1 , -1) + P(-1 , 1) + P(1 , 1);
+            double green , opposite , along_row , along_col , r , g , b;
+
+            if(method == DEMOSAIC_MHC)
+            {
+                double far_row = P(-2 , 0) + P(2 , 0);
+                double far_col = P(0 , -2) + P(0 , 2);
+                green = (4.0 * centre + 2.0 * cross - far_row - far_col) / 8.0;
+                opposite = (6.0 * centre + 2.0 * diagonal - 1.5 * (far_row + far_col)) / 8.0;
+                along_row = (5.0 * centre + 4.0 * (P(-1 , 0) + P(1 , 0)) - far_row - diagonal + 0.5 * far_col) / 8.0;
+                along_col = (5.0 * centre + 4.0 * (P(0 , -1) + P(0 , 1)) - far_col - diagonal + 0.5 * far_row) / 8.0;
+            }
+            else
+            {
+                green = cross / 4.0;
+                opposite = diagonal / 4.0;
+                along_row = (P(-1 , 0) + P(1 , 0)) / 2.0;
+                along_col = (P(0 , -1) + P(0 , 1)) / 2.0;
+            }
+#undef P
+
+            if(redRow && redCol)
+            {
+                r = centre; g = green; b = opposite;
+            }
+            else if(!redRow && !redCol)
+            {
+                r = opposite; g = green; b = centre;
+            }
+            else if(redRow)
+            {
+                r = along_row; g = centre; b = along_col;
+            }
+            else
+            {
+                r = along_col; g = centre; b = along_row;
+            }
+
+            unsigned char *p = rgb + ((size_t)y * width + x) * 3;
+            p[0] = to_byte(r , bit_depth);
+            p[1] = to_byte(g , bit_depth);
+            p[2] = to_byte(b , bit_depth);
+        }
+    }
+}
+
+static void reference_gray(const unsigned char *rgb , unsigned char *gray , size_t num_pixels)
+{
+    for(size_t i = 0 ; i < num_pixels ; i++)
+    {
+        gray[i] = (unsigned char)(0.299f * rgb[i * 3] + 0.587f * rgb[i * 3 + 1] + 0.114f * rgb[i * 3 + 2]);
+    }
+}
+
+static int max_difference(const unsigned char *a , const unsigned char *b , size_t n)
+{
+    int worst = 0;
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        int diff = abs((int)a[i] - (int)b[i]);
+        worst = diff > worst ? diff : worst;
+    }
+    return worst;
+}
+
+static double psnr(const float *scene , const unsigned char *rgb , size_t num_pixels)
+{
+    double error = 0.0;
+    for(size_t i = 0 ; i < num_pixels * 3 ; i++)
+    {
+        double diff = scene[i] * 255.0 - rgb[i];
+        error += diff * diff;
+    }
+    error /= num_pixels * 3;
+    return error > 0.0 ? 10.0 * log10(255.0 * 255.0 / error) : 99.0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int check_pattern(kernel_cache *cache , cl_command_queue queue , cl_context context , int bit_depth , cfa_pattern pattern)
+{
+    size_t num_pixels = (size_t)CHECK_WIDTH * CHECK_HEIGHT;
+    float *scene = (float*)malloc(num_pixels * 3 * sizeof(float));
+    unsigned short *raw = (unsigned short*)malloc(num_pixels * sizeof(unsigned short));
+    unsigned char *expected = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char *expected_gray = (unsigned char*)malloc(num_pixels);
+    unsigned char *result = (unsigned char*)malloc(num_pixels * 3);
+    cl_int err;
+    int failures = 0;
+
+    make_scene(scene , raw , CHECK_WIDTH , CHECK_HEIGHT , bit_depth , pattern);
+
+    cl_mem raw_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , num_pixels * sizeof(unsigned short) , raw , &err);
+    cl_mem out_buff = clCreateBuffer(context , CL_MEM_WRITE_ONLY , num_pixels * 3 , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the check buffers");
+        exit(1);
+    }
+
+    for(int method = DEMOSAIC_BILINEAR ; method <= DEMOSAIC_MHC ; method++)
+    {
+        reference_demosaic(raw , expected , CHECK_WIDTH , CHECK_HEIGHT , bit_depth , pattern , (demosaic_method)method);
+        reference_gray(expected , expected_gray , num_pixels);
+
+        for(int gray = 0 ; gray < 2 ; gray++)
+        {
+            size_t bytes = gray ? num_pixels : num_pixels * 3;
+
+            err = launch_demosaic(cache , queue , raw_buff , out_buff , CHECK_WIDTH , CHECK_HEIGHT , bit_depth , pattern ,
+                                  (demosaic_method)method , gray , NULL);
+            if(err == CL_SUCCESS)
+            {
+                err = clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+            }
+
+            int diff = err == CL_SUCCESS ? max_difference(gray ? expected_gray : expected , result , bytes) : -1;
+            if(diff < 0 || diff > 1)
+            {
+                printf("FAIL %2d-bit %s %-8s %s: %s %d\n", bit_depth , cfa_pattern_name(pattern) , method_names[method] ,
+                       gray ? "gray" : "rgb " , diff < 0 ? "error" : "max difference" , diff < 0 ? err : diff);
+                failures++;
+            }
+        }
+
+        if(bit_depth == FRAME_BIT_DEPTH)
+        {
+            printf("%2d-bit %s %-8s PSNR %.2f dB\n", bit_depth , cfa_pattern_name(pattern) , method_names[method] ,
+                   psnr(scene , expected , num_pixels));
+        }
+    }
+
+    clReleaseMemObject(raw_buff);
+    clReleaseMemObject(out_buff);
+    free(scene);
+    free(raw);
+    free(expected);
+    free(expected_gray);
+    free(result);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    cl_event event;
+    int failures = 0;
+
+    bench_init(&bench , 1);
+
+    // Correctness and quality
+    for(int pattern = CFA_RGGB ; pattern <= CFA_GBRG ; pattern++)
+    {
+        failures += check_pattern(&bench.cache , bench.queue , bench.context , FRAME_BIT_DEPTH , (cfa_pattern)pattern);
+    }
+    failures += check_pattern(&bench.cache , bench.queue , bench.context , 10 , CFA_GRBG);
+    failures += check_pattern(&bench.cache , bench.queue , bench.context , 16 , CFA_BGGR);
+
+    // Latency
+    size_t num_pixels = (size_t)FRAME_WIDTH * FRAME_HEIGHT;
+    size_t raw_bytes = num_pixels * sizeof(unsigned short);
+    float *scene = (float*)malloc(num_pixels * 3 * sizeof(float));
+    unsigned short *raw = (unsigned short*)malloc(raw_bytes);
+    unsigned char *frame = (unsigned char*)malloc(num_pixels * 3);
+    make_scene(scene , raw , FRAME_WIDTH , FRAME_HEIGHT , FRAME_BIT_DEPTH , CFA_RGGB);
+
+    cl_mem raw_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY , raw_bytes , NULL , &err);
+    cl_mem rgb_buff = clCreateBuffer(bench.context , CL_MEM_READ_WRITE , num_pixels * 3 , NULL , &err);
+    cl_mem gray_buff = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , num_pixels , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the frame buffers");
+        exit(1);
+    }
+
+    cl_kernel gray_kernel = kernel_cache_get(&bench.cache , "grayscale.cl" , "rgbToGrayScale" , NULL);
+    int width = FRAME_WIDTH , height = FRAME_HEIGHT;
+    clSetKernelArg(gray_kernel , 0 , sizeof(cl_mem) , &gray_buff);
+    clSetKernelArg(gray_kernel , 1 , sizeof(cl_mem) , &rgb_buff);
+    clSetKernelArg(gray_kernel , 2 , sizeof(int) , &width);
+    clSetKernelArg(gray_kernel , 3 , sizeof(int) , &height);
+    size_t gray_local[2] = {16 , 16};
+    size_t gray_global[2] = {(FRAME_WIDTH + 15) / 16 * 16 , (FRAME_HEIGHT + 15) / 16 * 16};
+
+    printf("\n%dx%d %d-bit RGGB , ms per frame\n", FRAME_WIDTH , FRAME_HEIGHT , FRAME_BIT_DEPTH);
+    printf("%-8s %-22s %10s %12s\n", "method" , "output" , "kernel" , "end to end");
+
+    for(int method = DEMOSAIC_BILINEAR ; method <= DEMOSAIC_MHC ; method++)
+    {
+        // 0: RGB , 1: RGB then rgbToGrayScale , 2: fused gray
+        for(int mode = 0 ; mode < 3 ; mode++)
+        {
+            const char *mode_name = mode == 0 ? "rgb" : mode == 1 ? "rgb + rgbToGrayScale" : "fused gray";
+            cl_mem out = mode == 2 ? gray_buff : rgb_buff;
+            size_t out_bytes = mode == 0 ? num_pixels * 3 : num_pixels;
+            double kernel_ms = 0.0;
+
+            // Warm-up launch builds the variant
+            launch_demosaic(&bench.cache , bench.queue , raw_buff , out , FRAME_WIDTH , FRAME_HEIGHT , FRAME_BIT_DEPTH ,
+                            CFA_RGGB , (demosaic_method)method , mode == 2 , NULL);
+            clFinish(bench.queue);
+
+            double start = bench_now_ms();
+            for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+            {
+                clEnqueueWriteBuffer(bench.queue , raw_buff , CL_FALSE , 0 , raw_bytes , raw , 0 , NULL , NULL);
+                if(launch_demosaic(&bench.cache , bench.queue , raw_buff , out , FRAME_WIDTH , FRAME_HEIGHT , FRAME_BIT_DEPTH ,
+                                   CFA_RGGB , (demosaic_method)method , mode == 2 , &event) != CL_SUCCESS)
+                {
+                    printf("Couldn't enqueue demosaic\n");
+                    exit(1);
+                }
+                kernel_ms += bench_event_ms(event);
+
+                if(mode == 1)
+                {
+                    clEnqueueNDRangeKernel(bench.queue , gray_kernel , 2 , NULL , gray_global , gray_local , 0 , NULL , &event);
+                    kernel_ms += bench_event_ms(event);
+                }
+                clEnqueueReadBuffer(bench.queue , mode == 0 ? rgb_buff : gray_buff , CL_TRUE , 0 , out_bytes , frame , 0 , NULL , NULL);
+            }
+            double total_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+            printf("%-8s %-22s %10.3f %12.3f\n", method_names[method] , mode_name , kernel_ms / NUM_ITERATIONS , total_ms);
+        }
+    }
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    free(scene);
+    free(raw);
+    free(frame);
+    clReleaseMemObject(raw_buff);
+    clReleaseMemObject(rgb_buff);
+    clReleaseMemObject(gray_buff);
+    bench_release(&bench);
+
+    return failures;
+}
@@ -0,0 +1,163 @@
+/*
+
+Task Graph Demo
+---------------
+
+1. Runs the mult , add and sub kernels from kernel_search.cl on the same two input arrays.
+2. The serial version is the pattern used in Host_Programming.c: one in-order queue and a blocking read after every kernel.
+3. The graph version declares the same work once. The three kernels only read a and b and each writes its own buffer, so
+   the graph has no edges between them and the device can overlap kernels and transfers.
+4. The graph is built once and submitted every iteration.
+5. The exit code is the number of kernels whose results do not match.
+
+Build:
+    gcc graph_demo.c task_graph.c bench_common.c kernel_cache.c verify.c thread_pool.c -o graph_demo -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_common.h"
+#include "task_graph.h"
+#include "verify.h"
+
+#define PROGRAM_FILE "kernel_search.cl"
+#define ARRAY_SIZE (1 << 22)
+#define NUM_ITERATIONS 20
+#define NUM_OPS 3
+
+static const char *kernel_names[NUM_OPS] = {"mult" , "add" , "sub"};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    task_graph graph;
+    cl_kernel kernels[NUM_OPS];
+    cl_mem a_buff , b_buff , out_buff[NUM_OPS];
+
+    bench_init(&bench , 0);
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        kernels[op] = kernel_cache_get(&bench.cache , PROGRAM_FILE , kernel_names[op] , NULL);
+    }
+
+    // Host data
+    size_t bytes = ARRAY_SIZE * sizeof(float);
+    float *a = (float*)malloc(bytes);
+    float *b = (float*)malloc(bytes);
+    float *expected = (float*)malloc(bytes);
+    float *results[NUM_OPS];
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        results[op] = (float*)malloc(bytes);
+    }
+    for(int i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        a[i] = i * 0.5f;
+        b[i] = (ARRAY_SIZE - i) * 0.25f;
+    }
+
+    a_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY , bytes , NULL , &err);
+    b_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY , bytes , NULL , &err);
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        out_buff[op] = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , bytes , NULL , &err);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the buffers");
+        exit(1);
+    }
+
+    size_t global_size = ARRAY_SIZE;
+
+    // Serial: in-order queue , blocking read after every kernel
+    double start = bench_now_ms();
+    for(int iter = 0 ; iter < NUM_ITERATIONS ; iter++)
+    {
+        clEnqueueWriteBuffer(bench.queue , a_buff , CL_TRUE , 0 , bytes , a , 0 , NULL , NULL);
+        clEnqueueWriteBuffer(bench.queue , b_buff , CL_TRUE , 0 , bytes , b , 0 , NULL , NULL);
+        for(int op = 0 ; op < NUM_OPS ; op++)
+        {
+            clSetKernelArg(kernels[op] , 0 , sizeof(cl_mem) , &a_buff);
+            clSetKernelArg(kernels[op] , 1 , sizeof(cl_mem) , &b_buff);
+            clSetKernelArg(kernels[op] , 2 , sizeof(cl_mem) , &out_buff[op]);
+            clEnqueueNDRangeKernel(bench.queue , kernels[op] , 1 , NULL , &global_size , NULL , 0 , NULL , NULL);
+            clEnqueueReadBuffer(bench.queue , out_buff[op] , CL_TRUE , 0 , bytes , results[op] , 0 , NULL , NULL);
+        }
+    }
+    double serial_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    // Graph: declared once , submitted every iteration
+    err = task_graph_init(&graph , bench.context , bench.device , 0);
+    if(err < 0)
+    {
+        printf("Couldn't create the task graph queues: %d\n", err);
+        exit(1);
+    }
+
+    int added = task_graph_add_write(&graph , a_buff , 0 , bytes , a) >= 0;
+    added &= task_graph_add_write(&graph , b_buff , 0 , bytes , b) >= 0;
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        task_arg args[3] = {TASK_ARG_MEM(a_buff , TASK_ACCESS_READ) ,
+                            TASK_ARG_MEM(b_buff , TASK_ACCESS_READ) ,
+                            TASK_ARG_MEM(out_buff[op] , TASK_ACCESS_WRITE)};
+        added &= task_graph_add_kernel(&graph , kernels[op] , 1 , &global_size , NULL , 3 , args) >= 0;
+        added &= task_graph_add_read(&graph , out_buff[op] , 0 , bytes , results[op]) >= 0;
+    }
+    if(!added)
+    {
+        printf("Couldn't add the nodes to the task graph\n");
+        exit(1);
+    }
+
+    start = bench_now_ms();
+    for(int iter = 0 ; iter < NUM_ITERATIONS ; iter++)
+    {
+        if(task_graph_run(&graph) != CL_SUCCESS)
+        {
+            printf("Couldn't submit the task graph\n");
+            exit(1);
+        }
+        task_graph_wait(&graph);
+    }
+    double graph_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    printf("Task graph: %d nodes , %s\n", graph.num_nodes ,
+           graph.out_of_order ? "one out-of-order queue" : "several in-order queues");
+    printf("Serial: %.3f ms per iteration\n", serial_ms);
+    printf("Graph : %.3f ms per iteration (%.2fx)\n\n", graph_ms , serial_ms / graph_ms);
+
+    // Verify the results of the last graph run
+    int failures = 0;
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        verify_report report;
+        for(int i = 0 ; i < ARRAY_SIZE ; i++)
+        {
+            expected[i] = op == 0 ? a[i] * b[i] : op == 1 ? a[i] + b[i] : a[i] - b[i];
+        }
+        failures += !verify_compare(NULL , expected , results[op] , ARRAY_SIZE , VERIFY_DEFAULT_TOLERANCE , &report);
+        verify_print(kernel_names[op] , &report);
+    }
+    printf("\n%d check(s) failed.\n", failures);
+
+    task_graph_release(&graph);
+    for(int op = 0 ; op < NUM_OPS ; op++)
+    {
+        clReleaseMemObject(out_buff[op]);
+        free(results[op]);
+    }
+    clReleaseMemObject(a_buff);
+    clReleaseMemObject(b_buff);
+    free(a);
+    free(b);
+    free(expected);
+    bench_release(&bench);
+
+    return failures;
+}
@@ -0,0 +1,36 @@
+__kernel void rgbToGrayScale(__global uchar *pOut , __global const uchar *pIn , int width , int height)
+{
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+
+    if(col < width && row < height)
+    {
+        int grayOffset = row * width + col;
+        int rgbOffset = grayOffset * 3;
+
+        uchar r = pIn[rgbOffset];
+        uchar g = pIn[rgbOffset + 1];
+        uchar b = pIn[rgbOffset + 2];
+
+        pOut[grayOffset] = (uchar)(0.299f * r + 0.587f * g + 0.114f * b);
+    }
+}
+
+// Same conversion from planar RGB (three planes of width x height): each plane is read consecutively across work-items
+__kernel void planarToGrayScale(__global uchar *pOut , __global const uchar *pIn , int width , int height)
+{
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+
+    if(col < width && row < height)
+    {
+        int plane = width * height;
+        int offset = row * width + col;
+
+        uchar r = pIn[offset];
+        uchar g = pIn[plane + offset];
+        uchar b = pIn[2 * plane + offset];
+
+        pOut[offset] = (uchar)(0.299f * r + 0.587f * g + 0.114f * b);
+    }
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "histogram.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int hist_plan_create(hist_plan *plan , cl_context context , int bit_depth , int num_bins)
+{
+    memset(plan , 0 , sizeof(*plan));
+
+    if(bit_depth < 1 || bit_depth > 16 || num_bins < 2 || num_bins > HIST_MAX_BINS ||
+       (num_bins & (num_bins - 1)) != 0 || num_bins > (1 << bit_depth))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    plan->context = context;
+    plan->bit_depth = bit_depth;
+    plan->num_bins = num_bins;
+    return CL_SUCCESS;
+}
+
+void hist_plan_release(hist_plan *plan)
+{
+    if(plan->partial != NULL)
+    {
+        clReleaseMemObject(plan->partial);
+    }
+    if(plan->hist != NULL)
+    {
+        clReleaseMemObject(plan->hist);
+    }
+    if(plan->lut != NULL)
+    {
+        clReleaseMemObject(plan->lut);
+    }
+    memset(plan , 0 , sizeof(*plan));
+}
+
+static cl_int ensure_buffer(cl_context context , cl_mem *buffer , size_t *current_bytes , size_t bytes)
+{
+    cl_int err = CL_SUCCESS;
+
+    if(*current_bytes >= bytes)
+    {
+        return CL_SUCCESS;
+    }
+    if(*buffer != NULL)
+    {
+        clReleaseMemObject(*buffer);
+    }
+
+    *buffer = clCreateBuffer(context , CL_MEM_READ_WRITE , bytes , NULL , &err);
+    *current_bytes = err < 0 ? 0 : bytes;
+    if(err < 0)
+    {
+        *buffer = NULL;
+    }
+    return err;
+}
+
+static cl_kernel get_kernel(kernel_cache *cache , const hist_plan *plan , const char *kernel_name)
+{
+    char options[96];
+
+    snprintf(options , sizeof(options) , "-DPIXEL_T=%s -DBIT_DEPTH=%d -DNUM_BINS=%d -DGROUP_SIZE=%d",
+             plan->bit_depth <= 8 ? "uchar" : "ushort" , plan->bit_depth , plan->num_bins , HIST_GROUP_SIZE);
+    return kernel_cache_get(cache , HISTOGRAM_PROGRAM , kernel_name , options);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/*
+    1. A few work-groups per compute unit are enough to fill the device. More groups only add partial histograms to merge.
+    2. Each group strides over the whole image , so the group count does not depend on the image size.
+*/
+cl_int launch_histogram(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , int num_pixels , cl_event *event)
+{
+    cl_kernel kernel;
+    cl_int err;
+
+    int num_groups = (int)cache->compute_units * HIST_GROUPS_PER_UNIT;
+    int needed = (num_pixels + HIST_GROUP_SIZE - 1) / HIST_GROUP_SIZE;
+    num_groups = needed < num_groups ? needed : num_groups;
+    num_groups = num_groups > 0 ? num_groups : 1;
+
+    err = ensure_buffer(plan->context , &plan->partial , &plan->partial_bytes , sizeof(cl_uint) * plan->num_bins * num_groups);
+    if(err == CL_SUCCESS)
+    {
+        err = ensure_buffer(plan->context , &plan->hist , &plan->hist_bytes , sizeof(cl_uint) * plan->num_bins);
+    }
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = get_kernel(cache , plan , "histogramLocal");
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(int) , &num_pixels);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &plan->partial);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size = HIST_GROUP_SIZE;
+    size_t global_size = (size_t)num_groups * HIST_GROUP_SIZE;
+    err = clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , &local_size , 0 , NULL , NULL);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = get_kernel(cache , plan , "histogramMerge");
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &plan->partial);
+    err |= clSetKernelArg(kernel , 1 , sizeof(int) , &num_groups);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &plan->hist);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t merge_size = plan->num_bins;
+    return clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &merge_size , NULL , 0 , NULL , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Lookup tables from plan->hist (one per tile) , then the per pixel mapping
+static cl_int equalize_tiles(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , cl_mem out ,
+                             int width , int height , int tile_w , int tile_h , int num_tiles , float clip_limit , cl_event *event)
+{
+    cl_kernel kernel;
+    cl_int err;
+
+    err = ensure_buffer(plan->context , &plan->lut , &plan->lut_bytes , sizeof(float) * plan->num_bins * num_tiles);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = get_kernel(cache , plan , "equalizeLut");
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &plan->hist);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &plan->lut);
+    err |= clSetKernelArg(kernel , 2 , sizeof(float) , &clip_limit);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size = HIST_GROUP_SIZE;
+    size_t global_size = (size_t)num_tiles * HIST_GROUP_SIZE;
+    err = clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , &local_size , 0 , NULL , NULL);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = get_kernel(cache , plan , "equalizeApply");
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &height);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &tile_w);
+    err |= clSetKernelArg(kernel , 5 , sizeof(int) , &tile_h);
+    err |= clSetKernelArg(kernel , 6 , sizeof(cl_mem) , &plan->lut);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t apply_local[2] = {16 , 16};
+    size_t apply_global[2] = {(width + 15) / 16 * 16 , (height + 15) / 16 * 16};
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , apply_global , apply_local , 0 , NULL , event);
+}
+
+cl_int launch_equalize(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , cl_mem out ,
+                       int width , int height , float clip_limit , cl_event *event)
+{
+    cl_int err = launch_histogram(cache , queue , plan , in , width * height , NULL);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    // One tile covering the whole frame
+    return equalize_tiles(cache , queue , plan , in , out , width , height , width , height , 1 , clip_limit , event);
+}
+
+cl_int launch_clahe(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , cl_mem out ,
+                    int width , int height , int tiles_x , int tiles_y , float clip_limit , cl_event *event)
+{
+    cl_kernel kernel;
+    cl_int err;
+
+    if(tiles_x < 1 || tiles_y < 1 || tiles_x > width || tiles_y > height)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    // Rounding the tile size up can leave fewer tiles than requested , use the count the kernels will see
+    int tile_w = (width + tiles_x - 1) / tiles_x;
+    int tile_h = (height + tiles_y - 1) / tiles_y;
+    tiles_x = (width + tile_w - 1) / tile_w;
+    tiles_y = (height + tile_h - 1) / tile_h;
+
+    err = ensure_buffer(plan->context , &plan->hist , &plan->hist_bytes , sizeof(cl_uint) * plan->num_bins * tiles_x * tiles_y);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    kernel = get_kernel(cache , plan , "tileHistogram");
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &height);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &tile_w);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &tile_h);
+    err |= clSetKernelArg(kernel , 5 , sizeof(cl_mem) , &plan->hist);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {HIST_GROUP_SIZE , 1};
+    size_t global_size[2] = {(size_t)tiles_x * HIST_GROUP_SIZE , (size_t)tiles_y};
+    err = clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , NULL);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    return equalize_tiles(cache , queue , plan , in , out , width , height , tile_w , tile_h , tiles_x * tiles_y , clip_limit , event);
+}
@@ -0,0 +1,234 @@
+/*
+    Histograms and histogram equalization of single channel images. The macros below are supplied as -D build options by histogram.c.
+
+    PIXEL_T     uchar for 8-bit data , ushort for 9 to 16-bit data
+    BIT_DEPTH   significant bits per pixel. Larger values are clamped to (1 << BIT_DEPTH) - 1.
+    NUM_BINS    power of two , at most 1 << BIT_DEPTH. Bin of a value v is (v * NUM_BINS) >> BIT_DEPTH.
+    GROUP_SIZE  work-group size of every kernel , a power of two
+
+    1. Privatized bins: every work-group counts into its own copy of the histogram in local memory with local atomics ,
+       which are far cheaper than global atomics , and contend only within the group. The copies are merged afterwards.
+    2. equalizeLut turns a histogram into a lookup table: the scaled cumulative distribution , after clipping every bin at
+       clip_limit times the mean bin height and spreading the clipped counts over all bins (contrast limiting).
+    3. equalizeApply maps each pixel through the lookup tables of the four nearest tiles and interpolates bilinearly between them ,
+       so tile borders don't show. With a single tile this is plain global equalization.
+*/
+
+#ifndef PIXEL_T
+#define PIXEL_T uchar
+#endif
+
+#ifndef BIT_DEPTH
+#define BIT_DEPTH 8
+#endif
+
+#ifndef NUM_BINS
+#define NUM_BINS 256
+#endif
+
+#ifndef GROUP_SIZE
+#define GROUP_SIZE 256
+#endif
+
+#define MAX_VALUE ((1 << BIT_DEPTH) - 1)
+
+inline uint bin_of(uint value)
+{
+    value = min(value , (uint)MAX_VALUE);
+    return (value * NUM_BINS) >> BIT_DEPTH;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// partial[group][bin] = count of bin among the pixels visited by the group
+__kernel void histogramLocal(__global const PIXEL_T *pIn , int num_pixels , __global uint *partial)
+{
+    __local uint bins[NUM_BINS];
+
+    int lid = get_local_id(0);
+    for(int b = lid ; b < NUM_BINS ; b += GROUP_SIZE)
+    {
+        bins[b] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(int i = get_global_id(0) ; i < num_pixels ; i += get_global_size(0))
+    {
+        atomic_inc(&bins[bin_of(pIn[i])]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    __global uint *out = partial + get_group_id(0) * NUM_BINS;
+    for(int b = lid ; b < NUM_BINS ; b += GROUP_SIZE)
+    {
+        out[b] = bins[b];
+    }
+}
+
+// hist[bin] = sum of partial[group][bin] over the groups , one work-item per bin
+__kernel void histogramMerge(__global const uint *partial , int num_groups , __global uint *hist)
+{
+    int bin = get_global_id(0);
+    if(bin >= NUM_BINS)
+    {
+        return;
+    }
+
+    uint sum = 0;
+    for(int g = 0 ; g < num_groups ; g++)
+    {
+        sum += partial[g * NUM_BINS + bin];
+    }
+    hist[bin] = sum;
+}
+
+// One work-group per tile: hist[tile][bin] for the tile_w x tile_h tile at (group 0 , group 1)
+__kernel void tileHistogram(__global const PIXEL_T *pIn , int width , int height , int tile_w , int tile_h , __global uint *hist)
+{
+    __local uint bins[NUM_BINS];
+
+    int lid = get_local_id(0);
+    int x0 = get_group_id(0) * tile_w;
+    int y0 = get_group_id(1) * tile_h;
+    int w = min(tile_w , width - x0);
+    int h = min(tile_h , height - y0);
+
+    for(int b = lid ; b < NUM_BINS ; b += GROUP_SIZE)
+    {
+        bins[b] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if(w > 0 && h > 0)
+    {
+        for(int i = lid ; i < w * h ; i += GROUP_SIZE)
+        {
+            int y = y0 + i / w;
+            int x = x0 + i % w;
+            atomic_inc(&bins[bin_of(pIn[y * width + x])]);
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    __global uint *out = hist + (get_group_id(1) * get_num_groups(0) + get_group_id(0)) * NUM_BINS;
+    for(int b = lid ; b < NUM_BINS ; b += GROUP_SIZE)
+    {
+        out[b] = bins[b];
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+inline float group_sum(__local float *scratch , float value)
+{
+    int lid = get_local_id(0);
+
+    scratch[lid] = value;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for(int offset = GROUP_SIZE / 2 ; offset > 0 ; offset >>= 1)
+    {
+        if(lid < offset)
+        {
+            scratch[lid] += scratch[lid + offset];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    float total = scratch[0];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    return total;
+}
+
+// Sum of the values of the work-items before this one
+inline float group_exclusive_scan(__local float *scratch , float value)
+{
+    int lid = get_local_id(0);
+
+    scratch[lid] = value;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for(int offset = 1 ; offset < GROUP_SIZE ; offset <<= 1)
+    {
+        float add = lid >= offset ? scratch[lid - offset] : 0.0f;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        scratch[lid] += add;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    float inclusive = scratch[lid];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    return inclusive - value;
+}
+
+/*
+    One work-group per histogram. Each work-item owns a contiguous chunk of bins.
+    lut[bin] = MAX_VALUE * cdf(bin) / pixels , where cdf includes the bin itself. clip_limit <= 0 disables clipping.
+    An empty tile gets the identity mapping.
+*/
+__kernel void equalizeLut(__global const uint *hist , __global float *lut , float clip_limit)
+{
+    __local float scratch[GROUP_SIZE];
+
+    const int chunk = (NUM_BINS + GROUP_SIZE - 1) / GROUP_SIZE;
+    int first = min((int)get_local_id(0) * chunk , NUM_BINS);
+    int last = min(first + chunk , NUM_BINS);
+    __global const uint *h = hist + get_group_id(0) * NUM_BINS;
+    __global float *out = lut + get_group_id(0) * NUM_BINS;
+
+    float count = 0.0f;
+    for(int b = first ; b < last ; b++)
+    {
+        count += h[b];
+    }
+    count = group_sum(scratch , count);
+
+    float limit = clip_limit > 0.0f ? max(1.0f , clip_limit * count / NUM_BINS) : count;
+    float excess = 0.0f;
+    for(int b = first ; b < last ; b++)
+    {
+        excess += max((float)h[b] - limit , 0.0f);
+    }
+    float spread = group_sum(scratch , excess) / NUM_BINS;
+
+    float part = 0.0f;
+    for(int b = first ; b < last ; b++)
+    {
+        part += min((float)h[b] , limit) + spread;
+    }
+    float cdf = group_exclusive_scan(scratch , part);
+
+    for(int b = first ; b < last ; b++)
+    {
+        cdf += min((float)h[b] , limit) + spread;
+        out[b] = count > 0.0f ? cdf * (MAX_VALUE / count) : b * (MAX_VALUE / (NUM_BINS - 1.0f));
+    }
+}
+
+// Tiles are tile_w x tile_h starting at (0 , 0). A single tile covering the image gives global equalization.
+__kernel void equalizeApply(__global const PIXEL_T *pIn , __global PIXEL_T *pOut , int width , int height ,
+                            int tile_w , int tile_h , __global const float *lut)
+{
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    int tiles_x = (width + tile_w - 1) / tile_w;
+    int tiles_y = (height + tile_h - 1) / tile_h;
+    uint bin = bin_of(pIn[row * width + col]);
+
+    // Position relative to the tile centres
+    float fx = (col + 0.5f) / tile_w - 0.5f;
+    float fy = (row + 0.5f) / tile_h - 0.5f;
+    int tx0 = clamp((int)floor(fx) , 0 , tiles_x - 1);
+    int ty0 = clamp((int)floor(fy) , 0 , tiles_y - 1);
+    int tx1 = min(tx0 + 1 , tiles_x - 1);
+    int ty1 = min(ty0 + 1 , tiles_y - 1);
+    float wx = clamp(fx - tx0 , 0.0f , 1.0f);
+    float wy = clamp(fy - ty0 , 0.0f , 1.0f);
+
+    float top = mix(lut[(ty0 * tiles_x + tx0) * NUM_BINS + bin] , lut[(ty0 * tiles_x + tx1) * NUM_BINS + bin] , wx);
+    float bottom = mix(lut[(ty1 * tiles_x + tx0) * NUM_BINS + bin] , lut[(ty1 * tiles_x + tx1) * NUM_BINS + bin] , wx);
+    float value = mix(top , bottom , wy);
+
+    pOut[row * width + col] = (PIXEL_T)min((uint)(value + 0.5f) , (uint)MAX_VALUE);
+}
@@ -0,0 +1,54 @@
+/*
+
+Histogram and Equalization
+--------------------------
+
+1. Image histograms for auto exposure and contrast , computed on the device so frames are never copied back to the host.
+   Data is single channel: 8-bit in uchar , or 9 to 16-bit in ushort (e.g. 10 or 12-bit sensor data).
+2. launch_histogram: every work-group builds a private histogram in local memory with local atomics , then the copies are merged.
+   The result (num_bins uint) is left in plan->hist.
+3. launch_equalize: global histogram equalization. launch_clahe: tiled , contrast limited equalization (CLAHE) with bilinear
+   interpolation between the tiles. Both write a frame of the same format , and out may be the same buffer as in.
+4. clip_limit is a multiple of the mean bin height (2 to 4 is typical). 0 disables clipping , which is plain equalization.
+5. The output is mapped per bin , so 16-bit data equalized with few bins comes out quantized to num_bins levels.
+6. A hist_plan owns the scratch buffers and grows them on demand. Kernels are specialized per pixel type , bit depth and bin count.
+
+*/
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "kernel_cache.h"
+
+#define HISTOGRAM_PROGRAM "histogram.cl"
+#define HIST_MAX_BINS 4096
+#define HIST_GROUP_SIZE 256
+#define HIST_GROUPS_PER_UNIT 4
+
+typedef struct
+{
+    cl_context context;
+    int bit_depth;
+    int num_bins;
+
+    cl_mem partial;             // per work-group histograms
+    size_t partial_bytes;
+    cl_mem hist;                // num_tiles x num_bins uint
+    size_t hist_bytes;
+    cl_mem lut;                 // num_tiles x num_bins float
+    size_t lut_bytes;
+} hist_plan;
+
+// num_bins must be a power of two between 2 and min(HIST_MAX_BINS , 1 << bit_depth)
+cl_int hist_plan_create(hist_plan *plan , cl_context context , int bit_depth , int num_bins);
+void hist_plan_release(hist_plan *plan);
+
+cl_int launch_histogram(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , int num_pixels , cl_event *event);
+
+cl_int launch_equalize(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , cl_mem out ,
+                       int width , int height , float clip_limit , cl_event *event);
+
+cl_int launch_clahe(kernel_cache *cache , cl_command_queue queue , hist_plan *plan , cl_mem in , cl_mem out ,
+                    int width , int height , int tiles_x , int tiles_y , float clip_limit , cl_event *event);
+
+#endif
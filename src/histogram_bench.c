@@ -0,0 +1,285 @@
+/*
+
+Histogram Benchmark
+-------------------
+
+1. A low contrast 1920x1080 frame (values crowded into a narrow band , plus a gradient) is uploaded once and never read back
+   except to check results.
+2. For 8-bit , 12-bit and 16-bit data at several bin counts it checks launch_histogram exactly against a C histogram , and
+   launch_equalize / launch_clahe against a C implementation of the same mapping (within one level).
+3. Times are per frame , wall clock with a clFinish , averaged over NUM_ITERATIONS.
+4. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 histogram_bench.c histogram.c bench_common.c kernel_cache.c -o histogram_bench -lOpenCL -lm
+
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "histogram.h"
+
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+#define CLAHE_TILES 8
+#define CLIP_LIMIT 2.0f
+#define NUM_ITERATIONS 10
+
+typedef struct
+{
+    int bit_depth;
+    int num_bins;
+} hist_format;
+
+static const hist_format formats[] = {{8 , 256} , {8 , 64} , {12 , 1024} , {12 , 4096} , {16 , 4096}};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static unsigned pixel_value(const void *pixels , int bit_depth , size_t i)
+{
+    unsigned max_value = (1u << bit_depth) - 1;
+    unsigned v = bit_depth <= 8 ? ((const unsigned char*)pixels)[i] : ((const unsigned short*)pixels)[i];
+    return v < max_value ? v : max_value;
+}
+
+static int pixel_bin(unsigned value , int bit_depth , int num_bins)
+{
+    return (int)(((unsigned long)value * num_bins) >> bit_depth);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Same formulas as histogram.cl , in double precision
+static void reference_lut(const unsigned *hist , int num_bins , int bit_depth , float clip_limit , double *lut)
+{
+    double max_value = (double)((1 << bit_depth) - 1);
+    double count = 0.0 , excess = 0.0 , cdf = 0.0;
+
+    for(int b = 0 ; b < num_bins ; b++)
+    {
+        count += hist[b];
+    }
+
+    double limit = clip_limit > 0.0f ? fmax(1.0 , clip_limit * count / num_bins) : count;
+    for(int b = 0 ; b < num_bins ; b++)
+    {
+        excess += fmax(hist[b] - limit , 0.0);
+    }
+
+    for(int b = 0 ; b < num_bins ; b++)
+    {
+        cdf += fmin(hist[b] , limit) + excess / num_bins;
+        lut[b] = count > 0.0 ? cdf * max_value / count : b * max_value / (num_bins - 1.0);
+    }
+}
+
+static void reference_equalize(const void *in , void *out , int width , int height , int bit_depth , int num_bins ,
+                               int tile_w , int tile_h , float clip_limit)
+{
+    int tiles_x = (width + tile_w - 1) / tile_w;
+    int tiles_y = (height + tile_h - 1) / tile_h;
+    unsigned *hist = (unsigned*)calloc((size_t)tiles_x * tiles_y * num_bins , sizeof(unsigned));
+    double *lut = (double*)malloc(sizeof(double) * tiles_x * tiles_y * num_bins);
+    unsigned max_value = (1u << bit_depth) - 1;
+
+    for(int y = 0 ; y < height ; y++)
+    {
+        for(int x = 0 ; x < width ; x++)
+        {
+            int tile = (y / tile_h) * tiles_x + x / tile_w;
+            hist[tile * num_bins + pixel_bin(pixel_value(in , bit_depth , (size_t)y * width + x) , bit_depth , num_bins)]++;
+        }
+    }
+    for(int t = 0 ; t < tiles_x * tiles_y ; t++)
+    {
+        reference_lut(hist + t * num_bins , num_bins , bit_depth , clip_limit , lut + t * num_bins);
+    }
+
+    for(int y = 0 ; y < height ; y++)
+    {
+        for(int x = 0 ; x < width ; x++)
+        {
+            int bin = pixel_bin(pixel_value(in , bit_depth , (size_t)y * width + x) , bit_depth , num_bins);
+            double fx = (x + 0.5) / tile_w - 0.5;
+            double fy = (y + 0.5) / tile_h - 0.5;
+            int tx0 = (int)floor(fx) , ty0 = (int)floor(fy);
+            tx0 = tx0 < 0 ? 0 : tx0 > tiles_x - 1 ? tiles_x - 1 : tx0;
+            ty0 = ty0 < 0 ? 0 : ty0 > tiles_y - 1 ? tiles_y - 1 : ty0;
+            int tx1 = tx0 + 1 < tiles_x ? tx0 + 1 : tiles_x - 1;
+            int ty1 = ty0 + 1 < tiles_y ? ty0 + 1 : tiles_y - 1;
+            double wx = fmin(fmax(fx - tx0 , 0.0) , 1.0);
+            double wy = fmin(fmax(fy - ty0 , 0.0) , 1.0);
+
+            double top = lut[(ty0 * tiles_x + tx0) * num_bins + bin] * (1.0 - wx) + lut[(ty0 * tiles_x + tx1) * num_bins + bin] * wx;
+            double bottom = lut[(ty1 * tiles_x + tx0) * num_bins + bin] * (1.0 - wx) + lut[(ty1 * tiles_x + tx1) * num_bins + bin] * wx;
+            unsigned value = (unsigned)(top * (1.0 - wy) + bottom * wy + 0.5);
+            value = value < max_value ? value : max_value;
+
+            if(bit_depth <= 8)
+            {
+                ((unsigned char*)out)[(size_t)y * width + x] = (unsigned char)value;
+            }
+            else
+            {
+                ((unsigned short*)out)[(size_t)y * width + x] = (unsigned short)value;
+            }
+        }
+    }
+
+    free(hist);
+    free(lut);
+}
+
+static int max_difference(const void *expected , const void *actual , int bit_depth , size_t num_pixels)
+{
+    int worst = 0;
+    for(size_t i = 0 ; i < num_pixels ; i++)
+    {
+        int diff = abs((int)pixel_value(expected , bit_depth , i) - (int)pixel_value(actual , bit_depth , i));
+        worst = diff > worst ? diff : worst;
+    }
+    return worst;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int run_format(kernel_cache *cache , cl_command_queue queue , cl_context context , hist_format format)
+{
+    size_t num_pixels = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT;
+    size_t bytes = num_pixels * (format.bit_depth <= 8 ? 1 : 2);
+    unsigned max_value = (1u << format.bit_depth) - 1;
+    void *frame = malloc(bytes);
+    void *expected = malloc(bytes);
+    void *result = malloc(bytes);
+    unsigned *hist = (unsigned*)calloc(format.num_bins , sizeof(unsigned));
+    unsigned *device_hist = (unsigned*)malloc(sizeof(unsigned) * format.num_bins);
+    hist_plan plan;
+    cl_int err;
+    int failures = 0;
+
+    // Low contrast: a horizontal gradient over 20% of the range , centred at 40% , with some noise
+    for(size_t i = 0 ; i < num_pixels ; i++)
+    {
+        double v = max_value * (0.3 + 0.2 * (i % IMAGE_WIDTH) / IMAGE_WIDTH) + (rand() % 17 - 8) * (max_value / 255.0);
+        unsigned value = v < 0.0 ? 0 : v > max_value ? max_value : (unsigned)v;
+        if(format.bit_depth <= 8)
+        {
+            ((unsigned char*)frame)[i] = (unsigned char)value;
+        }
+        else
+        {
+            ((unsigned short*)frame)[i] = (unsigned short)value;
+        }
+        hist[pixel_bin(value , format.bit_depth , format.num_bins)]++;
+    }
+
+    cl_mem in_buff = clCreateBuffer(context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , frame , &err);
+    cl_mem out_buff = clCreateBuffer(context , CL_MEM_READ_WRITE , bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the frame buffers");
+        exit(1);
+    }
+
+    if(hist_plan_create(&plan , context , format.bit_depth , format.num_bins) != CL_SUCCESS)
+    {
+        printf("Invalid histogram format %d-bit , %d bins\n", format.bit_depth , format.num_bins);
+        exit(1);
+    }
+
+    // Histogram
+    err = launch_histogram(cache , queue , &plan , in_buff , (int)num_pixels , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , plan.hist , CL_TRUE , 0 , sizeof(unsigned) * format.num_bins , device_hist , 0 , NULL , NULL);
+    }
+    int hist_ok = err == CL_SUCCESS && memcmp(hist , device_hist , sizeof(unsigned) * format.num_bins) == 0;
+    failures += !hist_ok;
+
+    double start = bench_now_ms();
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        launch_histogram(cache , queue , &plan , in_buff , (int)num_pixels , NULL);
+    }
+    clFinish(queue);
+    double hist_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    // Global equalization
+    reference_equalize(frame , expected , IMAGE_WIDTH , IMAGE_HEIGHT , format.bit_depth , format.num_bins ,
+                       IMAGE_WIDTH , IMAGE_HEIGHT , 0.0f);
+    err = launch_equalize(cache , queue , &plan , in_buff , out_buff , IMAGE_WIDTH , IMAGE_HEIGHT , 0.0f , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    }
+    int equalize_diff = err == CL_SUCCESS ? max_difference(expected , result , format.bit_depth , num_pixels) : -1;
+    failures += equalize_diff < 0 || equalize_diff > 1;
+
+    start = bench_now_ms();
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        launch_equalize(cache , queue , &plan , in_buff , out_buff , IMAGE_WIDTH , IMAGE_HEIGHT , 0.0f , NULL);
+    }
+    clFinish(queue);
+    double equalize_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    // CLAHE
+    int tile_w = (IMAGE_WIDTH + CLAHE_TILES - 1) / CLAHE_TILES;
+    int tile_h = (IMAGE_HEIGHT + CLAHE_TILES - 1) / CLAHE_TILES;
+    reference_equalize(frame , expected , IMAGE_WIDTH , IMAGE_HEIGHT , format.bit_depth , format.num_bins , tile_w , tile_h , CLIP_LIMIT);
+    err = launch_clahe(cache , queue , &plan , in_buff , out_buff , IMAGE_WIDTH , IMAGE_HEIGHT , CLAHE_TILES , CLAHE_TILES , CLIP_LIMIT , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    }
+    int clahe_diff = err == CL_SUCCESS ? max_difference(expected , result , format.bit_depth , num_pixels) : -1;
+    failures += clahe_diff < 0 || clahe_diff > 1;
+
+    start = bench_now_ms();
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        launch_clahe(cache , queue , &plan , in_buff , out_buff , IMAGE_WIDTH , IMAGE_HEIGHT , CLAHE_TILES , CLAHE_TILES , CLIP_LIMIT , NULL);
+    }
+    clFinish(queue);
+    double clahe_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    printf("%2d-bit %5d bins | %8.3f %8.2f %-4s | %8.3f %-4s | %8.3f %-4s\n", format.bit_depth , format.num_bins ,
+           hist_ms , bytes / (hist_ms * 1.0e6) , hist_ok ? "ok" : "FAIL" ,
+           equalize_ms , (equalize_diff >= 0 && equalize_diff <= 1) ? "ok" : "FAIL" ,
+           clahe_ms , (clahe_diff >= 0 && clahe_diff <= 1) ? "ok" : "FAIL");
+
+    hist_plan_release(&plan);
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+    free(frame);
+    free(expected);
+    free(result);
+    free(hist);
+    free(device_hist);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    int failures = 0;
+
+    bench_init(&bench , 0);
+
+    printf("%dx%d frame , CLAHE %dx%d tiles , clip limit %.1f , times in ms per frame\n\n",
+           IMAGE_WIDTH , IMAGE_HEIGHT , CLAHE_TILES , CLAHE_TILES , CLIP_LIMIT);
+    printf("%-16s | %8s %8s %-4s | %8s %-4s | %8s %-4s\n", "format" , "hist" , "GB/s" , "" , "equalize" , "" , "clahe" , "");
+
+    for(size_t f = 0 ; f < sizeof(formats) / sizeof(formats[0]) ; f++)
+    {
+        failures += run_format(&bench.cache , bench.queue , bench.context , formats[f]);
+    }
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    bench_release(&bench);
+
+    return failures;
+}
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel_cache.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+char* read_program_file(const char *file_name , size_t *program_size)
+{
+    FILE *program_handle = fopen(file_name , "r");
+    if(program_handle == NULL)
+    {
+        perror("Couldn't find the program file");
+        exit(1);
+    }
+
+    fseek(program_handle , 0 , SEEK_END);
+    *program_size = ftell(program_handle);
+    rewind(program_handle);
+
+    char *program_buffer = (char*)malloc(*program_size + 1);
+    program_buffer[*program_size] = '\0';
+    fread(program_buffer , sizeof(char) , *program_size , program_handle);
+    fclose(program_handle);
+
+    return program_buffer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static char* copy_string(const char *str)
+{
+    size_t len = strlen(str);
+    char *copy = (char*)malloc(len + 1);
+    memcpy(copy , str , len + 1);
+    return copy;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_program build_variant(kernel_cache *cache , const char *source_file , const char *options)
+{
+    cl_program program;
+    cl_int err;
+    size_t program_size;
+
+    char *program_buffer = read_program_file(source_file , &program_size);
+    program = clCreateProgramWithSource(cache->context , 1 , (const char**)&program_buffer , &program_size , &err);
+    free(program_buffer);
+
+    if(err < 0)
+    {
+        perror("Couldn't create the program");
+        exit(1);
+    }
+
+    err = clBuildProgram(program , 1 , &cache->device , options , NULL , NULL);
+    if(err < 0)
+    {
+        size_t log_size;
+        clGetProgramBuildInfo(program , cache->device , CL_PROGRAM_BUILD_LOG , 0 , NULL , &log_size);
+        char *program_log = (char*)malloc(log_size + 1);
+        program_log[log_size] = '\0';
+        clGetProgramBuildInfo(program , cache->device , CL_PROGRAM_BUILD_LOG , log_size + 1 , program_log , NULL);
+        printf("Build log (%s , options \"%s\"):\n%s\n", source_file , options , program_log);
+        free(program_log);
+        exit(1);
+    }
+
+    return program;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void kernel_cache_init(kernel_cache *cache , cl_context context , cl_device_id device)
+{
+    cache->context = context;
+    cache->device = device;
+    cache->device_type = CL_DEVICE_TYPE_DEFAULT;
+    cache->compute_units = 1;
+    cache->preferred_float_width = 0;
+    cache->native_float_width = 0;
+    clGetDeviceInfo(device , CL_DEVICE_TYPE , sizeof(cl_device_type) , &cache->device_type , NULL);
+    clGetDeviceInfo(device , CL_DEVICE_MAX_COMPUTE_UNITS , sizeof(cl_uint) , &cache->compute_units , NULL);
+    clGetDeviceInfo(device , CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &cache->preferred_float_width , NULL);
+    clGetDeviceInfo(device , CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &cache->native_float_width , NULL);
+    cache->entries = NULL;
+    cache->num_entries = 0;
+    cache->capacity = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_kernel kernel_cache_get(kernel_cache *cache , const char *source_file , const char *kernel_name , const char *options)
+{
+    cl_program program = NULL;
+    cl_kernel kernel;
+    cl_int err;
+    size_t i;
+
+    if(options == NULL)
+    {
+        options = "";
+    }
+
+    // Look for the exact variant first, and remember a program built with the same source and options
+    for(i = 0 ; i < cache->num_entries ; i++)
+    {
+        kernel_cache_entry *entry = &cache->entries[i];
+        if(strcmp(entry->source_file , source_file) != 0 || strcmp(entry->options , options) != 0)
+        {
+            continue;
+        }
+
+        if(strcmp(entry->kernel_name , kernel_name) == 0)
+        {
+            cache->hits++;
+            return entry->kernel;
+        }
+        program = entry->program;
+    }
+
+    cache->misses++;
+    if(program == NULL)
+    {
+        program = build_variant(cache , source_file , options);
+    }
+    else
+    {
+        clRetainProgram(program);
+    }
+
+    kernel = clCreateKernel(program , kernel_name , &err);
+    if(err < 0)
+    {
+        printf("Couldn't create kernel %s from %s: %d\n", kernel_name , source_file , err);
+        exit(1);
+    }
+
+    if(cache->num_entries == cache->capacity)
+    {
+        cache->capacity = cache->capacity ? cache->capacity * 2 : 8;
+        cache->entries = (kernel_cache_entry*)realloc(cache->entries , cache->capacity * sizeof(kernel_cache_entry));
+    }
+
+    kernel_cache_entry *entry = &cache->entries[cache->num_entries++];
+    entry->source_file = copy_string(source_file);
+    entry->kernel_name = copy_string(kernel_name);
+    entry->options = copy_string(options);
+    entry->program = program;
+    entry->kernel = kernel;
+
+    return kernel;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void kernel_cache_release(kernel_cache *cache)
+{
+    for(size_t i = 0 ; i < cache->num_entries ; i++)
+    {
+        clReleaseKernel(cache->entries[i].kernel);
+        clReleaseProgram(cache->entries[i].program);
+        free(cache->entries[i].source_file);
+        free(cache->entries[i].kernel_name);
+        free(cache->entries[i].options);
+    }
+
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->num_entries = 0;
+    cache->capacity = 0;
+}
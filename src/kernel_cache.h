@@ -0,0 +1,65 @@
+/*
+
+Kernel Variant Cache
+--------------------
+
+1. clBuildProgram accepts an options string, and every "-D NAME=VALUE" in it is visible to the kernel source as a preprocessor macro.
+2. Building the same .cl file with different -D constants produces specialized kernel variants: loop bounds become compile time constants,
+   so the compiler can unroll loops, fold index arithmetic and remove bounds checks.
+3. Building a program is expensive (milliseconds), so each (source file , kernel name , options) variant is built once and memoized here.
+4. Variants that share a source file and options share a single cl_program.
+5. kernel_cache_init also reads the device properties that launchers size their work from (type , compute units , float vector
+   widths) , so a launch does not pay for clGetDeviceInfo calls.
+
+*/
+
+#ifndef KERNEL_CACHE_H
+#define KERNEL_CACHE_H
+
+#include <stddef.h>
+
+#ifdef MAC
+#include <OpenCL/cl.h>
+#else
+#ifndef CL_TARGET_OPENCL_VERSION
+#define CL_TARGET_OPENCL_VERSION 300
+#endif
+#include <CL/cl.h>
+#endif
+
+typedef struct
+{
+    char *source_file;
+    char *kernel_name;
+    char *options;
+    cl_program program;
+    cl_kernel kernel;
+} kernel_cache_entry;
+
+typedef struct
+{
+    cl_context context;
+    cl_device_id device;
+    cl_device_type device_type;
+    cl_uint compute_units;
+    cl_uint preferred_float_width;      // CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , 0 when not reported
+    cl_uint native_float_width;         // CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT
+    kernel_cache_entry *entries;
+    size_t num_entries;
+    size_t capacity;
+    size_t hits;
+    size_t misses;
+} kernel_cache;
+
+// Reads a whole kernel source file into a NUL terminated buffer. The caller frees the buffer.
+char* read_program_file(const char *file_name , size_t *program_size);
+
+void kernel_cache_init(kernel_cache *cache , cl_context context , cl_device_id device);
+
+// Returns the kernel built from source_file with the given options, building it on the first request only.
+// The returned kernel is owned by the cache and must not be released by the caller.
+cl_kernel kernel_cache_get(kernel_cache *cache , const char *source_file , const char *kernel_name , const char *options);
+
+void kernel_cache_release(kernel_cache *cache);
+
+#endif
@@ -0,0 +1,78 @@
+#include <stdio.h>
+
+#include "layout.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int launch_transpose(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int rows , int cols ,
+                        const char *type_name , int padded , cl_event *event)
+{
+    char options[96];
+    cl_kernel kernel;
+    cl_int err;
+
+    if(rows < 1 || cols < 1)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    snprintf(options , sizeof(options) , "-DT=%s -DTILE=%d -DBLOCK_ROWS=%d -DPAD=%d",
+             type_name , TRANSPOSE_TILE , TRANSPOSE_BLOCK_ROWS , padded ? 1 : 0);
+    kernel = kernel_cache_get(cache , LAYOUT_PROGRAM , "transpose" , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &rows);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &cols);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {TRANSPOSE_TILE , TRANSPOSE_BLOCK_ROWS};
+    size_t global_size[2] = {(size_t)(cols + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE * TRANSPOSE_TILE ,
+                             (size_t)(rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE * TRANSPOSE_BLOCK_ROWS};
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_int launch_channels(kernel_cache *cache , cl_command_queue queue , const char *kernel_name , cl_mem in , cl_mem out ,
+                              int num_pixels , int channels , cl_event *event)
+{
+    char options[64];
+    cl_kernel kernel;
+    cl_int err;
+
+    if(num_pixels < 1 || (channels != 3 && channels != 4))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    snprintf(options , sizeof(options) , "-DCHANNELS=%d -DGROUP_SIZE=%d", channels , LAYOUT_GROUP_SIZE);
+    kernel = kernel_cache_get(cache , LAYOUT_PROGRAM , kernel_name , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &num_pixels);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size = LAYOUT_GROUP_SIZE;
+    size_t global_size = (size_t)(num_pixels + LAYOUT_GROUP_SIZE - 1) / LAYOUT_GROUP_SIZE * LAYOUT_GROUP_SIZE;
+
+    return clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , &local_size , 0 , NULL , event);
+}
+
+cl_int launch_to_planar(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int num_pixels , int channels ,
+                        cl_event *event)
+{
+    return launch_channels(cache , queue , "interleavedToPlanar" , in , out , num_pixels , channels , event);
+}
+
+cl_int launch_to_interleaved(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int num_pixels , int channels ,
+                             cl_event *event)
+{
+    return launch_channels(cache , queue , "planarToInterleaved" , in , out , num_pixels , channels , event);
+}
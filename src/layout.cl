@@ -0,0 +1,149 @@
+/*
+    Layout conversions. The macros are supplied as -D build options by layout.c.
+
+    T            element type of the transpose (default float)
+    TILE         edge of the square tile a work-group transposes (default 32)
+    BLOCK_ROWS   rows of the work-group. Each work-item moves TILE / BLOCK_ROWS elements (default 8).
+    PAD          extra columns in the local tile , 1 avoids bank conflicts (default 1)
+    CHANNELS     channels of the interleaved image , 3 or 4 (default 3)
+    GROUP_SIZE   work-group size of the channel conversions (default 256)
+
+    1. A naive transpose reads rows and writes columns , so one of the two is strided by the matrix width and every work-item
+       touches a different memory segment. Here a work-group reads a TILE x TILE tile row by row into local memory and writes it
+       back row by row at the transposed position: both global accesses are coalesced.
+    2. The write phase reads the local tile by columns. Local memory is split into banks of 4 bytes. With TILE 32 and no padding
+       every element of a column sits in the same bank , and the 32 reads of a column are serialized. One column of padding shifts
+       each row by one bank , so a column covers all banks.
+    3. interleavedToPlanar turns RGBRGB... into RRR...GGG...BBB... (and planarToInterleaved back). With three channels a work-item
+       cannot load its pixel in one aligned access , so the work-group stages its GROUP_SIZE pixels in local memory: the loads
+       and stores of the interleaved side are byte-consecutive across work-items , and each plane is written or read consecutively.
+       Four channel pixels are uchar4 and need no staging.
+*/
+
+#ifndef T
+#define T float
+#endif
+
+#ifndef TILE
+#define TILE 32
+#endif
+
+#ifndef BLOCK_ROWS
+#define BLOCK_ROWS 8
+#endif
+
+#ifndef PAD
+#define PAD 1
+#endif
+
+#ifndef CHANNELS
+#define CHANNELS 3
+#endif
+
+#ifndef GROUP_SIZE
+#define GROUP_SIZE 256
+#endif
+
+/*
+    pIn is rows x cols , pOut is cols x rows.
+    Launched with a TILE x BLOCK_ROWS work-group and one group per tile: global size (ceil(cols / TILE) * TILE , ceil(rows / TILE) * BLOCK_ROWS).
+*/
+__kernel void transpose(__global const T *pIn , __global T *pOut , int rows , int cols)
+{
+    __local T tile[TILE][TILE + PAD];
+
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+    int col = get_group_id(0) * TILE + localCol;
+    int row = get_group_id(1) * TILE + localRow;
+
+    for(int j = 0 ; j < TILE ; j += BLOCK_ROWS)
+    {
+        if(col < cols && row + j < rows)
+        {
+            tile[localRow + j][localCol] = pIn[(row + j) * cols + col];
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // The tile at (group x , group y) of the input lands at (group y , group x) of the output
+    col = get_group_id(1) * TILE + localCol;
+    row = get_group_id(0) * TILE + localRow;
+
+    for(int j = 0 ; j < TILE ; j += BLOCK_ROWS)
+    {
+        if(col < rows && row + j < cols)
+        {
+            pOut[(row + j) * rows + col] = tile[localCol][localRow + j];
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// pIn: num_pixels x CHANNELS interleaved. pOut: CHANNELS planes of num_pixels.
+__kernel void interleavedToPlanar(__global const uchar *pIn , __global uchar *pOut , int num_pixels)
+{
+#if CHANNELS == 4
+    int pixel = get_global_id(0);
+    if(pixel < num_pixels)
+    {
+        uchar4 value = vload4(pixel , pIn);
+        pOut[pixel] = value.x;
+        pOut[num_pixels + pixel] = value.y;
+        pOut[2 * num_pixels + pixel] = value.z;
+        pOut[3 * num_pixels + pixel] = value.w;
+    }
+#else
+    __local uchar stage[GROUP_SIZE * CHANNELS];
+
+    int lid = get_local_id(0);
+    int first = get_group_id(0) * GROUP_SIZE;
+    int count = min(GROUP_SIZE , num_pixels - first);
+
+    for(int i = lid ; i < count * CHANNELS ; i += GROUP_SIZE)
+    {
+        stage[i] = pIn[first * CHANNELS + i];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if(lid < count)
+    {
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            pOut[c * num_pixels + first + lid] = stage[lid * CHANNELS + c];
+        }
+    }
+#endif
+}
+
+__kernel void planarToInterleaved(__global const uchar *pIn , __global uchar *pOut , int num_pixels)
+{
+#if CHANNELS == 4
+    int pixel = get_global_id(0);
+    if(pixel < num_pixels)
+    {
+        uchar4 value = (uchar4)(pIn[pixel] , pIn[num_pixels + pixel] , pIn[2 * num_pixels + pixel] , pIn[3 * num_pixels + pixel]);
+        vstore4(value , pixel , pOut);
+    }
+#else
+    __local uchar stage[GROUP_SIZE * CHANNELS];
+
+    int lid = get_local_id(0);
+    int first = get_group_id(0) * GROUP_SIZE;
+    int count = min(GROUP_SIZE , num_pixels - first);
+
+    if(lid < count)
+    {
+        for(int c = 0 ; c < CHANNELS ; c++)
+        {
+            stage[lid * CHANNELS + c] = pIn[c * num_pixels + first + lid];
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(int i = lid ; i < count * CHANNELS ; i += GROUP_SIZE)
+    {
+        pOut[first * CHANNELS + i] = stage[i];
+    }
+#endif
+}
@@ -0,0 +1,38 @@
+/*
+
+Layout Conversion
+-----------------
+
+1. Kernels read fastest when consecutive work-items touch consecutive addresses (coalesced access). rgbToGrayScale and
+   blurKernel stride through interleaved RGB , and mat_vec_mult_n walks a row per work-item , so neighbouring work-items
+   are a whole row apart. Converting the data once puts it in the layout the consumer reads.
+2. launch_transpose: out-of-place transpose of a rows x cols matrix of any OpenCL scalar type , tiled through padded local memory.
+   Pass padded = 0 only to measure the cost of local memory bank conflicts.
+3. launch_to_planar / launch_to_interleaved: interleaved (RGBRGB...) to planar (RRR...GGG...BBB...) and back , 3 or 4 channels.
+4. Planar and transposed consumers: planarToGrayScale (grayscale.cl) , blurPlanarKernel (launch_blur_planar , specialize.h) and
+   mat_vec_mult_t (mat_vec.cl , takes the transposed matrix).
+5. Each conversion reads and writes every byte once , so its speed is compared against a device to device copy of the same size.
+
+*/
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "kernel_cache.h"
+
+#define LAYOUT_PROGRAM "layout.cl"
+#define TRANSPOSE_TILE 32
+#define TRANSPOSE_BLOCK_ROWS 8
+#define LAYOUT_GROUP_SIZE 256
+
+// in: rows x cols , out: cols x rows. type_name is the OpenCL element type , e.g. "float" or "uchar".
+cl_int launch_transpose(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int rows , int cols ,
+                        const char *type_name , int padded , cl_event *event);
+
+// in: num_pixels x channels bytes , out: channels planes of num_pixels bytes (and the reverse)
+cl_int launch_to_planar(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int num_pixels , int channels ,
+                        cl_event *event);
+cl_int launch_to_interleaved(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int num_pixels , int channels ,
+                             cl_event *event);
+
+#endif
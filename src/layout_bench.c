@@ -0,0 +1,479 @@
+/*
+
+Layout Conversion Benchmark
+---------------------------
+
+1. Checks launch_transpose (float and uchar , padded and unpadded , sizes that are not multiples of the tile) and the interleaved /
+   planar conversions for 3 and 4 channels , both directions , against the host.
+2. Checks that the planar and transposed consumers give the same results as the originals: planarToGrayScale against
+   rgbToGrayScale , blurPlanarKernel against blurKernel , mat_vec_mult_t against mat_vec_mult_n.
+3. Reports the effective bandwidth of every conversion (bytes read + bytes written per second) next to clEnqueueCopyBuffer
+   of the same size , the practical upper bound for a kernel that reads and writes every byte once.
+4. Times each consumer on both layouts , so the conversion cost can be weighed against what the consumer gains.
+5. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 layout_bench.c layout.c specialize.c bench_common.c kernel_cache.c verify.c thread_pool.c -o layout_bench -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "layout.h"
+#include "specialize.h"
+#include "verify.h"
+
+#define MAT_SIZE 4096
+#define FRAME_WIDTH 1920
+#define FRAME_HEIGHT 1080
+#define CHECK_WIDTH 161
+#define CHECK_HEIGHT 97
+#define BLUR_RADIUS 3
+#define NUM_ITERATIONS 10
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Read + write bandwidth in GB/s of a kernel that moves bytes in each direction
+static double gb_per_s(size_t bytes , double ms)
+{
+    return ms > 0.0 ? 2.0 * bytes / (ms * 1.0e6) : 0.0;
+}
+
+static void fill_bytes(unsigned char *data , size_t n)
+{
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        data[i] = (unsigned char)((i * 2654435761u) >> 13);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Consumers that have no launcher of their own
+static cl_int launch_gray(kernel_cache *cache , cl_command_queue queue , const char *kernel_name , cl_mem in , cl_mem out ,
+                          int width , int height , cl_event *event)
+{
+    cl_kernel kernel = kernel_cache_get(cache , "grayscale.cl" , kernel_name , NULL);
+    cl_int err;
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &height);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {16 , 16};
+    size_t global_size[2] = {(width + 15) / 16 * 16 , (height + 15) / 16 * 16};
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
+
+// transposed = 0: mat_vec_mult_n on a rows x cols matrix. transposed = 1: mat_vec_mult_t on its cols x rows transpose.
+static cl_int launch_mat_vec(kernel_cache *cache , cl_command_queue queue , int transposed , cl_mem matrix , cl_mem vector ,
+                             cl_mem result , int rows , int cols , cl_event *event)
+{
+    cl_kernel kernel = kernel_cache_get(cache , "mat_vec.cl" , transposed ? "mat_vec_mult_t" : "mat_vec_mult_n" , NULL);
+    cl_int err;
+    int arg = 3;
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &matrix);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &vector);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &result);
+    if(transposed)
+    {
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &rows);
+    }
+    err |= clSetKernelArg(kernel , arg , sizeof(int) , &cols);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t global_size = rows;
+    return clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int check_transpose(kernel_cache *cache , cl_command_queue queue , cl_context context , int rows , int cols ,
+                           const char *type_name , size_t element_size , int padded)
+{
+    size_t bytes = (size_t)rows * cols * element_size;
+    unsigned char *in = (unsigned char*)malloc(bytes);
+    unsigned char *expected = (unsigned char*)malloc(bytes);
+    unsigned char *result = (unsigned char*)malloc(bytes);
+    cl_int err;
+
+    fill_bytes(in , bytes);
+    for(int r = 0 ; r < rows ; r++)
+    {
+        for(int c = 0 ; c < cols ; c++)
+        {
+            memcpy(expected + ((size_t)c * rows + r) * element_size , in + ((size_t)r * cols + c) * element_size , element_size);
+        }
+    }
+
+    cl_mem in_buff = bench_buffer(context , bytes , in);
+    cl_mem out_buff = bench_buffer(context , bytes , NULL);
+
+    err = launch_transpose(cache , queue , in_buff , out_buff , rows , cols , type_name , padded , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    }
+
+    int failed = err != CL_SUCCESS || memcmp(expected , result , bytes) != 0;
+    if(failed)
+    {
+        printf("FAIL transpose %s %dx%d%s (error %d)\n", type_name , rows , cols , padded ? "" : " unpadded" , err);
+    }
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+    free(in);
+    free(expected);
+    free(result);
+    return failed;
+}
+
+static int check_channels(kernel_cache *cache , cl_command_queue queue , cl_context context , int num_pixels , int channels)
+{
+    size_t bytes = (size_t)num_pixels * channels;
+    unsigned char *interleaved = (unsigned char*)malloc(bytes);
+    unsigned char *expected = (unsigned char*)malloc(bytes);
+    unsigned char *result = (unsigned char*)malloc(bytes);
+    int failures = 0;
+    cl_int err;
+
+    fill_bytes(interleaved , bytes);
+    for(int i = 0 ; i < num_pixels ; i++)
+    {
+        for(int c = 0 ; c < channels ; c++)
+        {
+            expected[(size_t)c * num_pixels + i] = interleaved[(size_t)i * channels + c];
+        }
+    }
+
+    cl_mem interleaved_buff = bench_buffer(context , bytes , interleaved);
+    cl_mem planar_buff = bench_buffer(context , bytes , NULL);
+    cl_mem back_buff = bench_buffer(context , bytes , NULL);
+
+    err = launch_to_planar(cache , queue , interleaved_buff , planar_buff , num_pixels , channels , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , planar_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    }
+    if(err != CL_SUCCESS || memcmp(expected , result , bytes) != 0)
+    {
+        printf("FAIL to_planar %d channels , %d pixels (error %d)\n", channels , num_pixels , err);
+        failures++;
+    }
+
+    err = launch_to_interleaved(cache , queue , planar_buff , back_buff , num_pixels , channels , NULL);
+    if(err == CL_SUCCESS)
+    {
+        err = clEnqueueReadBuffer(queue , back_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    }
+    if(err != CL_SUCCESS || memcmp(interleaved , result , bytes) != 0)
+    {
+        printf("FAIL to_interleaved %d channels , %d pixels (error %d)\n", channels , num_pixels , err);
+        failures++;
+    }
+
+    clReleaseMemObject(interleaved_buff);
+    clReleaseMemObject(planar_buff);
+    clReleaseMemObject(back_buff);
+    free(interleaved);
+    free(expected);
+    free(result);
+    return failures;
+}
+
+// Each planar or transposed consumer against the original on the same data
+static int check_consumers(kernel_cache *cache , cl_command_queue queue , cl_context context)
+{
+    int width = CHECK_WIDTH , height = CHECK_HEIGHT , num_pixels = CHECK_WIDTH * CHECK_HEIGHT;
+    size_t rgb_bytes = (size_t)num_pixels * 3;
+    unsigned char *rgb = (unsigned char*)malloc(rgb_bytes);
+    unsigned char *expected = (unsigned char*)malloc(rgb_bytes);
+    unsigned char *result = (unsigned char*)malloc(rgb_bytes);
+    int failures = 0;
+    cl_int err;
+
+    fill_bytes(rgb , rgb_bytes);
+    cl_mem rgb_buff = bench_buffer(context , rgb_bytes , rgb);
+    cl_mem planar_buff = bench_buffer(context , rgb_bytes , NULL);
+    cl_mem out_buff = bench_buffer(context , rgb_bytes , NULL);
+    cl_mem blurred_buff = bench_buffer(context , rgb_bytes , NULL);
+
+    // Gray
+    err = launch_to_planar(cache , queue , rgb_buff , planar_buff , num_pixels , 3 , NULL);
+    err |= launch_gray(cache , queue , "rgbToGrayScale" , rgb_buff , out_buff , width , height , NULL);
+    err |= clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , num_pixels , expected , 0 , NULL , NULL);
+    err |= launch_gray(cache , queue , "planarToGrayScale" , planar_buff , out_buff , width , height , NULL);
+    err |= clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , num_pixels , result , 0 , NULL , NULL);
+    if(err != CL_SUCCESS || memcmp(expected , result , num_pixels) != 0)
+    {
+        printf("FAIL planarToGrayScale (error %d)\n", err);
+        failures++;
+    }
+
+    // Blur , the planar result converted back to interleaved
+    err = launch_blur(cache , queue , rgb_buff , out_buff , width , height , BLUR_RADIUS , VARIANT_AUTO , NULL);
+    err |= clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , rgb_bytes , expected , 0 , NULL , NULL);
+    err |= launch_blur_planar(cache , queue , planar_buff , blurred_buff , width , height , BLUR_RADIUS , VARIANT_AUTO , NULL);
+    err |= launch_to_interleaved(cache , queue , blurred_buff , out_buff , num_pixels , 3 , NULL);
+    err |= clEnqueueReadBuffer(queue , out_buff , CL_TRUE , 0 , rgb_bytes , result , 0 , NULL , NULL);
+    if(err != CL_SUCCESS || memcmp(expected , result , rgb_bytes) != 0)
+    {
+        printf("FAIL blurPlanarKernel (error %d)\n", err);
+        failures++;
+    }
+
+    clReleaseMemObject(rgb_buff);
+    clReleaseMemObject(planar_buff);
+    clReleaseMemObject(out_buff);
+    clReleaseMemObject(blurred_buff);
+    free(rgb);
+    free(expected);
+    free(result);
+
+    // Matrix vector product
+    int rows = 517 , cols = 300;
+    float *matrix = (float*)malloc(sizeof(float) * rows * cols);
+    float *vector = (float*)malloc(sizeof(float) * cols);
+    float *result_n = (float*)malloc(sizeof(float) * rows);
+    float *result_t = (float*)malloc(sizeof(float) * rows);
+    verify_report report;
+
+    for(int i = 0 ; i < rows * cols ; i++)
+    {
+        matrix[i] = (float)((i * 37) % 101) / 101.0f - 0.5f;
+    }
+    for(int i = 0 ; i < cols ; i++)
+    {
+        vector[i] = (float)(i % 13) / 13.0f;
+    }
+
+    cl_mem matrix_buff = bench_buffer(context , sizeof(float) * rows * cols , matrix);
+    cl_mem transposed_buff = bench_buffer(context , sizeof(float) * rows * cols , NULL);
+    cl_mem vector_buff = bench_buffer(context , sizeof(float) * cols , vector);
+    cl_mem result_buff = bench_buffer(context , sizeof(float) * rows , NULL);
+
+    err = launch_mat_vec(cache , queue , 0 , matrix_buff , vector_buff , result_buff , rows , cols , NULL);
+    err |= clEnqueueReadBuffer(queue , result_buff , CL_TRUE , 0 , sizeof(float) * rows , result_n , 0 , NULL , NULL);
+    err |= launch_transpose(cache , queue , matrix_buff , transposed_buff , rows , cols , "float" , 1 , NULL);
+    err |= launch_mat_vec(cache , queue , 1 , transposed_buff , vector_buff , result_buff , rows , cols , NULL);
+    err |= clEnqueueReadBuffer(queue , result_buff , CL_TRUE , 0 , sizeof(float) * rows , result_t , 0 , NULL , NULL);
+    if(err != CL_SUCCESS || !verify_compare(NULL , result_n , result_t , rows , VERIFY_DEFAULT_TOLERANCE , &report))
+    {
+        printf("FAIL mat_vec_mult_t (error %d)\n", err);
+        verify_print("mat_vec_mult_t" , &report);
+        failures++;
+    }
+
+    clReleaseMemObject(matrix_buff);
+    clReleaseMemObject(transposed_buff);
+    clReleaseMemObject(vector_buff);
+    clReleaseMemObject(result_buff);
+    free(matrix);
+    free(vector);
+    free(result_n);
+    free(result_t);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double time_copy(cl_command_queue queue , cl_mem src , cl_mem dst , size_t bytes)
+{
+    cl_event event;
+    double ms = 0.0;
+
+    clEnqueueCopyBuffer(queue , src , dst , 0 , 0 , bytes , 0 , NULL , NULL);
+    clFinish(queue);
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        clEnqueueCopyBuffer(queue , src , dst , 0 , 0 , bytes , 0 , NULL , &event);
+        ms += bench_event_ms(event);
+    }
+    return ms / NUM_ITERATIONS;
+}
+
+static void print_bandwidth(const char *name , size_t bytes , double ms , double copy_ms)
+{
+    printf("%-34s %10.3f %10.1f %9.0f%%\n", name , ms , gb_per_s(bytes , ms) , ms > 0.0 ? 100.0 * copy_ms / ms : 0.0);
+}
+
+static void time_transposes(kernel_cache *cache , cl_command_queue queue , cl_context context)
+{
+    size_t bytes = sizeof(float) * MAT_SIZE * MAT_SIZE;
+    cl_mem in_buff = bench_buffer(context , bytes , NULL);
+    cl_mem out_buff = bench_buffer(context , bytes , NULL);
+    cl_event event;
+
+    double copy_ms = time_copy(queue , in_buff , out_buff , bytes);
+    printf("\n%dx%d float , %.0f MB\n", MAT_SIZE , MAT_SIZE , bytes / 1048576.0);
+    printf("%-34s %10s %10s %10s\n", "operation" , "ms" , "GB/s" , "of copy");
+    print_bandwidth("clEnqueueCopyBuffer" , bytes , copy_ms , copy_ms);
+
+    for(int padded = 0 ; padded < 2 ; padded++)
+    {
+        double ms = 0.0;
+        launch_transpose(cache , queue , in_buff , out_buff , MAT_SIZE , MAT_SIZE , "float" , padded , NULL);
+        clFinish(queue);
+        for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+        {
+            launch_transpose(cache , queue , in_buff , out_buff , MAT_SIZE , MAT_SIZE , "float" , padded , &event);
+            ms += bench_event_ms(event);
+        }
+        print_bandwidth(padded ? "transpose (padded tile)" : "transpose (unpadded tile)" , bytes , ms / NUM_ITERATIONS , copy_ms);
+    }
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+}
+
+static void time_channels(kernel_cache *cache , cl_command_queue queue , cl_context context , int channels)
+{
+    int num_pixels = FRAME_WIDTH * FRAME_HEIGHT;
+    size_t bytes = (size_t)num_pixels * channels;
+    cl_mem in_buff = bench_buffer(context , bytes , NULL);
+    cl_mem out_buff = bench_buffer(context , bytes , NULL);
+    cl_event event;
+
+    double copy_ms = time_copy(queue , in_buff , out_buff , bytes);
+    printf("\n%dx%d , %d channels\n", FRAME_WIDTH , FRAME_HEIGHT , channels);
+    print_bandwidth("clEnqueueCopyBuffer" , bytes , copy_ms , copy_ms);
+
+    for(int direction = 0 ; direction < 2 ; direction++)
+    {
+        double ms = 0.0;
+        for(int i = -1 ; i < NUM_ITERATIONS ; i++)
+        {
+            // The first launch builds the variant and is not timed
+            cl_event *timed = i < 0 ? NULL : &event;
+            if(direction == 0)
+            {
+                launch_to_planar(cache , queue , in_buff , out_buff , num_pixels , channels , timed);
+            }
+            else
+            {
+                launch_to_interleaved(cache , queue , in_buff , out_buff , num_pixels , channels , timed);
+            }
+            if(i < 0)
+            {
+                clFinish(queue);
+            }
+            else
+            {
+                ms += bench_event_ms(event);
+            }
+        }
+        print_bandwidth(direction == 0 ? "interleaved -> planar" : "planar -> interleaved" , bytes , ms / NUM_ITERATIONS , copy_ms);
+    }
+
+    clReleaseMemObject(in_buff);
+    clReleaseMemObject(out_buff);
+}
+
+static double time_consumer(kernel_cache *cache , cl_command_queue queue , int which , cl_mem in , cl_mem out , cl_mem vector)
+{
+    cl_event event;
+    double ms = 0.0;
+
+    for(int i = -1 ; i < NUM_ITERATIONS ; i++)
+    {
+        cl_event *timed = i < 0 ? NULL : &event;
+        switch(which)
+        {
+            case 0: launch_gray(cache , queue , "rgbToGrayScale" , in , out , FRAME_WIDTH , FRAME_HEIGHT , timed); break;
+            case 1: launch_gray(cache , queue , "planarToGrayScale" , in , out , FRAME_WIDTH , FRAME_HEIGHT , timed); break;
+            case 2: launch_blur(cache , queue , in , out , FRAME_WIDTH , FRAME_HEIGHT , BLUR_RADIUS , VARIANT_AUTO , timed); break;
+            case 3: launch_blur_planar(cache , queue , in , out , FRAME_WIDTH , FRAME_HEIGHT , BLUR_RADIUS , VARIANT_AUTO , timed); break;
+            case 4: launch_mat_vec(cache , queue , 0 , in , vector , out , MAT_SIZE , MAT_SIZE , timed); break;
+            case 5: launch_mat_vec(cache , queue , 1 , in , vector , out , MAT_SIZE , MAT_SIZE , timed); break;
+        }
+        if(i < 0)
+        {
+            clFinish(queue);
+        }
+        else
+        {
+            ms += bench_event_ms(event);
+        }
+    }
+    return ms / NUM_ITERATIONS;
+}
+
+static void time_consumers(kernel_cache *cache , cl_command_queue queue , cl_context context)
+{
+    static const char *names[] = {"rgbToGrayScale" , "planarToGrayScale" , "blurKernel" , "blurPlanarKernel" ,
+                                  "mat_vec_mult_n" , "mat_vec_mult_t"};
+    size_t image_bytes = (size_t)FRAME_WIDTH * FRAME_HEIGHT * 3;
+    size_t matrix_bytes = sizeof(float) * MAT_SIZE * MAT_SIZE;
+
+    cl_mem image_in = bench_buffer(context , image_bytes , NULL);
+    cl_mem image_out = bench_buffer(context , image_bytes , NULL);
+    cl_mem matrix = bench_buffer(context , matrix_bytes , NULL);
+    cl_mem vector = bench_buffer(context , sizeof(float) * MAT_SIZE , NULL);
+    cl_mem result = bench_buffer(context , sizeof(float) * MAT_SIZE , NULL);
+
+    printf("\nConsumers , kernel ms (images %dx%d , blur radius %d , matrix %dx%d)\n", FRAME_WIDTH , FRAME_HEIGHT , BLUR_RADIUS ,
+           MAT_SIZE , MAT_SIZE);
+    printf("%-34s %10s %10s\n", "kernel" , "original" , "converted");
+    for(int which = 0 ; which < 6 ; which += 2)
+    {
+        int is_matrix = which == 4;
+        double original = time_consumer(cache , queue , which , is_matrix ? matrix : image_in , is_matrix ? result : image_out , vector);
+        double converted = time_consumer(cache , queue , which + 1 , is_matrix ? matrix : image_in , is_matrix ? result : image_out ,
+                                         vector);
+        char name[64];
+        snprintf(name , sizeof(name) , "%s / %s" , names[which] , names[which + 1]);
+        printf("%-34s %10.3f %10.3f\n", name , original , converted);
+    }
+
+    clReleaseMemObject(image_in);
+    clReleaseMemObject(image_out);
+    clReleaseMemObject(matrix);
+    clReleaseMemObject(vector);
+    clReleaseMemObject(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    int failures = 0;
+
+    bench_init(&bench , 1);
+
+    // Correctness
+    for(int padded = 0 ; padded < 2 ; padded++)
+    {
+        failures += check_transpose(&bench.cache , bench.queue , bench.context , 333 , 517 , "float" , sizeof(float) , padded);
+        failures += check_transpose(&bench.cache , bench.queue , bench.context , 64 , 32 , "float" , sizeof(float) , padded);
+        failures += check_transpose(&bench.cache , bench.queue , bench.context , 1 , 1000 , "float" , sizeof(float) , padded);
+        failures += check_transpose(&bench.cache , bench.queue , bench.context , 77 , 100 , "uchar" , 1 , padded);
+    }
+    for(int channels = 3 ; channels <= 4 ; channels++)
+    {
+        failures += check_channels(&bench.cache , bench.queue , bench.context , CHECK_WIDTH * CHECK_HEIGHT , channels);
+        failures += check_channels(&bench.cache , bench.queue , bench.context , LAYOUT_GROUP_SIZE , channels);
+        failures += check_channels(&bench.cache , bench.queue , bench.context , 7 , channels);
+    }
+    failures += check_consumers(&bench.cache , bench.queue , bench.context);
+
+    // Bandwidth
+    time_transposes(&bench.cache , bench.queue , bench.context);
+    time_channels(&bench.cache , bench.queue , bench.context , 3);
+    time_channels(&bench.cache , bench.queue , bench.context , 4);
+    time_consumers(&bench.cache , bench.queue , bench.context);
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    bench_release(&bench);
+
+    return failures;
+}
@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "verify.h"
+
 /*
     1. This block handles platform-specific differences between macOS and other systems.
        macOS uses a different path(<OpenCL/cl.h>) to include the OpenCL header , while linux
@@ -187,10 +189,12 @@ int main() {
 
     clEnqueueReadBuffer(queue, res_buff , CL_TRUE, 0 , sizeof(float)*4, result , 0 , NULL , NULL);
 
-    if(result[0] == correct[0] &&
-       result[1] == correct[1] &&
-       result[2] == correct[2] &&
-       result[3] == correct[3])
+    /*
+        1. verify_compare : Compares the device result with the host result using ulp / relative tolerances. The device computes
+                            dot() with its own rounding (often FMA), so exact == comparison can fail on a correct result.
+    */
+    verify_report report;
+    if(verify_compare(NULL , correct , result , 4 , VERIFY_DEFAULT_TOLERANCE , &report))
        {
         printf("Matrix - Vector Multiplication successful. \n");
        }
@@ -198,6 +202,7 @@ int main() {
     {
         printf("Matrix - Vector Multiplication unsuccessful. \n");
     }
+    verify_print("mat_vec_mult" , &report);
 
     clReleaseMemObject(mat_buff);
     clReleaseMemObject(vec_buff);
@@ -4,4 +4,42 @@ __kernel void mat_vec_mult(__global float4* matrix,
 {
     int i = get_global_id(0);
     result[i] = dot(matrix[i] , vector[0]);
-}
\ No newline at end of file
+}
+
+__kernel void mat_vec_mult_n(__global const float* matrix,
+                             __global const float* vector,
+                             __global float* result,
+                             int cols)
+{
+    int i = get_global_id(0);
+    float sum = 0.0f;
+    for(int k = 0 ; k < cols ; k++)
+    {
+        sum += matrix[i * cols + k] * vector[k];
+    }
+    result[i] = sum;
+}
+
+/*
+    Same product from the transposed matrix (cols x rows , see launch_transpose in layout.h).
+    In mat_vec_mult_n neighbouring work-items read elements a whole row apart. Here they read neighbouring elements of a row of matrixT.
+*/
+__kernel void mat_vec_mult_t(__global const float* matrixT,
+                             __global const float* vector,
+                             __global float* result,
+                             int rows,
+                             int cols)
+{
+    int i = get_global_id(0);
+    if(i >= rows)
+    {
+        return;
+    }
+
+    float sum = 0.0f;
+    for(int k = 0 ; k < cols ; k++)
+    {
+        sum += matrixT[k * rows + i] * vector[k];
+    }
+    result[i] = sum;
+}
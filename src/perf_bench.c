@@ -0,0 +1,104 @@
+/*
+
+Counter Instrumentation Benchmark
+---------------------------------
+
+1. Runs the OpenCL backend of compute.h with a perf_session attached , so every upload , launch and read back is counted
+   with perf_event_open (see perf_counters.h).
+2. The counters only see host threads , so the numbers describe the kernels when the device is a CPU device (e.g. PoCL or the
+   Intel CPU runtime). On a GPU they describe the driver threads and the waits , and a warning is printed.
+3. The sizes are chosen so the elementwise ops and mat_vec_mult are streaming (well over the last level cache): the B/flop
+   column should put them on the memory side of the roofline. The blur reuses every byte (2r + 1)^2 times , but it is integer
+   arithmetic with no flops , so it has no roofline point: compare its DRAM MB to its nominal bytes instead.
+4. NUM_LAUNCHES launches per kernel give the per launch spread and the per kernel totals (launch #0 left out). compute.c builds
+   each program outside the regions , so launch #0 only carries the one off warm-up of the runtime and of the host arrays.
+5. Without an OpenCL device , or without any counter , there is nothing to measure and the exit code is 0.
+
+Build:
+    gcc -O3 perf_bench.c compute.c cpu_backend.c verify.c thread_pool.c specialize.c vector_ops.c kernel_cache.c perf_counters.c -o perf_bench -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "compute.h"
+
+#define ARRAY_SIZE (16 << 20)
+#define MAT_ROWS 4096
+#define MAT_COLS 4096
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+#define BLUR_SIZE 3
+#define NUM_LAUNCHES 5
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    compute_context ctx;
+    perf_session session;
+    cl_device_type type;
+
+    compute_init(&ctx);
+    if(!ctx.has_opencl)
+    {
+        printf("No OpenCL device , nothing to instrument.\n");
+        compute_release(&ctx);
+        return 0;
+    }
+
+    clGetDeviceInfo(ctx.device , CL_DEVICE_TYPE , sizeof(type) , &type , NULL);
+    if(!(type & CL_DEVICE_TYPE_CPU))
+    {
+        printf("Warning: the device is not a CPU device , the counters only see the host side of each launch.\n");
+    }
+
+    if(!perf_session_init(&session , stdout))
+    {
+        printf("perf_event_open is not available , nothing to instrument.\n");
+        perf_session_release(&session);
+        compute_release(&ctx);
+        return 0;
+    }
+
+    float *a = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *b = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    float *result = (float*)malloc(ARRAY_SIZE * sizeof(float));
+    for(size_t i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        a[i] = (float)rand() / RAND_MAX;
+        b[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+
+    size_t num_pixels = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT;
+    unsigned char *image = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char *image_out = (unsigned char*)malloc(num_pixels * 3);
+    for(size_t i = 0 ; i < num_pixels * 3 ; i++)
+    {
+        image[i] = (unsigned char)(rand() & 0xFF);
+    }
+
+    ctx.perf = &session;
+    for(int launch = 0 ; launch < NUM_LAUNCHES ; launch++)
+    {
+        compute_add_arrays(&ctx , BACKEND_OPENCL , a , b , result , ARRAY_SIZE);
+        compute_mult(&ctx , BACKEND_OPENCL , a , b , result , ARRAY_SIZE);
+        compute_mat_vec_mult(&ctx , BACKEND_OPENCL , a , b , result , MAT_ROWS , MAT_COLS);
+        compute_rgb_to_gray(&ctx , BACKEND_OPENCL , image_out , image , IMAGE_WIDTH , IMAGE_HEIGHT);
+        compute_blur(&ctx , BACKEND_OPENCL , image , image_out , IMAGE_WIDTH , IMAGE_HEIGHT , BLUR_SIZE);
+    }
+
+    printf("\n");
+    perf_report(&session , stdout);
+
+    free(a);
+    free(b);
+    free(result);
+    free(image);
+    free(image_out);
+    ctx.perf = NULL;
+    perf_session_release(&session);
+    compute_release(&ctx);
+
+    return 0;
+}
@@ -0,0 +1,436 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *counter_names[] = {"task-clock" , "cycles" , "instructions" , "LLC misses"};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC , &ts);
+    return ts.tv_sec * 1.0e3 + ts.tv_nsec * 1.0e-6;
+}
+
+#ifdef __linux__
+//----------------------------------------------------------------------------------------------------------------------------------
+static int open_event(unsigned int type , unsigned long long config , int pid , int cpu , int exclude_kernel)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr , 0 , sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open , &attr , pid , cpu , -1 , 0);
+}
+
+// Scaled for multiplexing: when more events are open than the PMU has counters , each one only runs part of the time
+static double read_event(int fd)
+{
+    unsigned long long values[3];
+
+    if(fd < 0 || read(fd , values , sizeof(values)) != sizeof(values))
+    {
+        return 0.0;
+    }
+    if(values[2] == 0)
+    {
+        return 0.0;
+    }
+    return (double)values[0] * ((double)values[1] / values[2]);
+}
+
+static void open_thread(perf_session *session , int tid)
+{
+    static const unsigned int types[] = {PERF_TYPE_SOFTWARE , PERF_TYPE_HARDWARE , PERF_TYPE_HARDWARE , PERF_TYPE_HARDWARE};
+    static const unsigned long long configs[] = {PERF_COUNT_SW_TASK_CLOCK , PERF_COUNT_HW_CPU_CYCLES , PERF_COUNT_HW_INSTRUCTIONS ,
+                                                 PERF_COUNT_HW_CACHE_MISSES};
+    int index = session->num_threads++;
+
+    session->tids[index] = tid;
+    for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+    {
+        // User space only: that is all perf_event_paranoid 2 (the usual default) allows
+        session->fds[index][c] = open_event(types[c] , configs[c] , tid , -1 , 1);
+        if(session->fds[index][c] >= 0)
+        {
+            session->counter_available[c] = 1;
+        }
+    }
+}
+
+static void scan_threads(perf_session *session)
+{
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+
+    if(dir == NULL)
+    {
+        return;
+    }
+
+    while((entry = readdir(dir)) != NULL && session->num_threads < PERF_MAX_THREADS)
+    {
+        int tid = atoi(entry->d_name);
+        int known = 0;
+
+        if(tid <= 0)
+        {
+            continue;
+        }
+        for(int t = 0 ; t < session->num_threads && !known ; t++)
+        {
+            known = session->tids[t] == tid;
+        }
+        if(!known)
+        {
+            open_thread(session , tid);
+        }
+    }
+    closedir(dir);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Reads one line of a sysfs file
+static int read_sysfs(const char *path , char *line , size_t size)
+{
+    FILE *file = fopen(path , "r");
+    if(file == NULL)
+    {
+        return 0;
+    }
+    int ok = fgets(line , (int)size , file) != NULL;
+    fclose(file);
+    return ok;
+}
+
+// "event=0x04,umask=0x03" -> 0x0304
+static unsigned long long parse_event_config(const char *text)
+{
+    unsigned long long config = 0;
+    const char *field;
+
+    if((field = strstr(text , "event=")) != NULL)
+    {
+        config |= strtoull(field + 6 , NULL , 0) & 0xff;
+    }
+    if((field = strstr(text , "umask=")) != NULL)
+    {
+        config |= (strtoull(field + 6 , NULL , 0) & 0xff) << 8;
+    }
+    return config;
+}
+
+/*
+    1. Every memory controller is a PMU named uncore_imc_<n> (uncore_imc_free_running_<n> on some client parts is skipped).
+    2. Its events/cas_count_read and events/cas_count_write files give the event encoding. Each CAS moves one 64 byte line.
+    3. Uncore events are per socket: they are opened on the first CPU of the PMU's cpumask , for all processes.
+*/
+static void open_imc(perf_session *session)
+{
+    static const char *events[] = {"cas_count_read" , "cas_count_write"};
+    const char *base = "/sys/bus/event_source/devices";
+    DIR *dir = opendir(base);
+    struct dirent *entry;
+    char path[512] , line[128];
+
+    if(dir == NULL)
+    {
+        return;
+    }
+
+    while((entry = readdir(dir)) != NULL && session->num_imc + 2 <= PERF_MAX_IMC)
+    {
+        if(strncmp(entry->d_name , "uncore_imc_" , 11) != 0 || strstr(entry->d_name , "free_running") != NULL)
+        {
+            continue;
+        }
+
+        snprintf(path , sizeof(path) , "%s/%s/type" , base , entry->d_name);
+        if(!read_sysfs(path , line , sizeof(line)))
+        {
+            continue;
+        }
+        unsigned int type = (unsigned int)strtoul(line , NULL , 10);
+
+        snprintf(path , sizeof(path) , "%s/%s/cpumask" , base , entry->d_name);
+        int cpu = read_sysfs(path , line , sizeof(line)) ? atoi(line) : 0;
+
+        for(int e = 0 ; e < 2 ; e++)
+        {
+            snprintf(path , sizeof(path) , "%s/%s/events/%s" , base , entry->d_name , events[e]);
+            if(!read_sysfs(path , line , sizeof(line)))
+            {
+                continue;
+            }
+            int fd = open_event(type , parse_event_config(line) , -1 , cpu , 0);
+            if(fd >= 0)
+            {
+                session->imc_fds[session->num_imc++] = fd;
+            }
+        }
+    }
+    closedir(dir);
+    session->imc_available = session->num_imc > 0;
+}
+
+static void read_totals(const perf_session *session , double *counts , double *imc)
+{
+    for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+    {
+        counts[c] = 0.0;
+        for(int t = 0 ; t < session->num_threads ; t++)
+        {
+            counts[c] += read_event(session->fds[t][c]);
+        }
+    }
+
+    *imc = 0.0;
+    for(int i = 0 ; i < session->num_imc ; i++)
+    {
+        *imc += read_event(session->imc_fds[i]);
+    }
+}
+
+static void close_events(perf_session *session)
+{
+    for(int t = 0 ; t < session->num_threads ; t++)
+    {
+        for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+        {
+            if(session->fds[t][c] >= 0)
+            {
+                close(session->fds[t][c]);
+            }
+        }
+    }
+    for(int i = 0 ; i < session->num_imc ; i++)
+    {
+        close(session->imc_fds[i]);
+    }
+}
+#else
+//----------------------------------------------------------------------------------------------------------------------------------
+// No perf_event_open: regions still record wall time , every counter reads n/a
+static void scan_threads(perf_session *session)
+{
+    (void)session;
+}
+
+static void open_imc(perf_session *session)
+{
+    (void)session;
+}
+
+static void read_totals(const perf_session *session , double *counts , double *imc)
+{
+    (void)session;
+    memset(counts , 0 , sizeof(double) * PERF_NUM_COUNTERS);
+    *imc = 0.0;
+}
+
+static void close_events(perf_session *session)
+{
+    (void)session;
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int perf_session_init(perf_session *session , FILE *out)
+{
+    memset(session , 0 , sizeof(*session));
+
+    scan_threads(session);
+    open_imc(session);
+
+    if(out != NULL)
+    {
+        fprintf(out , "perf counters:");
+        for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+        {
+            fprintf(out , " %s %s ,", counter_names[c] , session->counter_available[c] ? "yes" : "n/a");
+        }
+        fprintf(out , " DRAM %s\n", session->imc_available ? "uncore_imc" :
+                session->counter_available[PERF_LLC_MISSES] ? "~ from LLC misses" : "n/a");
+    }
+
+    return session->counter_available[PERF_TASK_CLOCK];
+}
+
+void perf_session_release(perf_session *session)
+{
+    close_events(session);
+    free(session->records);
+    memset(session , 0 , sizeof(*session));
+}
+
+void perf_region_begin(perf_session *session)
+{
+    scan_threads(session);
+    read_totals(session , session->start_counts , &session->start_imc);
+    session->start_ms = now_ms();
+}
+
+void perf_region_end(perf_session *session , cl_command_queue queue , const char *name , double bytes , double flops)
+{
+    double counts[PERF_NUM_COUNTERS] , imc;
+    perf_record *record;
+
+    if(queue != NULL)
+    {
+        clFinish(queue);
+    }
+    double end_ms = now_ms();
+    read_totals(session , counts , &imc);
+
+    if(session->num_records == session->capacity)
+    {
+        int capacity = session->capacity > 0 ? 2 * session->capacity : 64;
+        perf_record *records = (perf_record*)realloc(session->records , sizeof(perf_record) * capacity);
+        if(records == NULL)
+        {
+            return;
+        }
+        session->records = records;
+        session->capacity = capacity;
+    }
+
+    record = &session->records[session->num_records++];
+    memset(record , 0 , sizeof(*record));
+    snprintf(record->name , sizeof(record->name) , "%s" , name);
+    for(int r = 0 ; r < session->num_records - 1 ; r++)
+    {
+        record->launch += strcmp(session->records[r].name , record->name) == 0;
+    }
+
+    record->ms = end_ms - session->start_ms;
+    for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+    {
+        record->counts[c] = counts[c] - session->start_counts[c];
+    }
+    record->dram_bytes = session->imc_available ? (imc - session->start_imc) * PERF_LINE_BYTES :
+                                                  record->counts[PERF_LLC_MISSES] * PERF_LINE_BYTES;
+    record->bytes = bytes;
+    record->flops = flops;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void print_value(FILE *out , int available , double value , const char *format)
+{
+    if(available)
+    {
+        fprintf(out , format , value);
+    }
+    else
+    {
+        fprintf(out , "%10s" , "n/a");
+    }
+}
+
+static void print_record(const perf_session *session , FILE *out , const perf_record *record , const char *label)
+{
+    int has_cycles = session->counter_available[PERF_CYCLES] && record->counts[PERF_CYCLES] > 0.0;
+    int has_dram = session->imc_available || session->counter_available[PERF_LLC_MISSES];
+
+    fprintf(out , "%-30s %9.3f" , label , record->ms);
+    print_value(out , session->counter_available[PERF_TASK_CLOCK] , record->counts[PERF_TASK_CLOCK] * 1.0e-6 , "%10.3f");
+    print_value(out , session->counter_available[PERF_CYCLES] , record->counts[PERF_CYCLES] * 1.0e-6 , "%10.2f");
+    print_value(out , session->counter_available[PERF_INSTRUCTIONS] , record->counts[PERF_INSTRUCTIONS] * 1.0e-6 , "%10.2f");
+    print_value(out , has_cycles && session->counter_available[PERF_INSTRUCTIONS] ,
+                record->counts[PERF_INSTRUCTIONS] / (has_cycles ? record->counts[PERF_CYCLES] : 1.0) , "%10.2f");
+    print_value(out , session->counter_available[PERF_LLC_MISSES] , record->counts[PERF_LLC_MISSES] * 1.0e-3 , "%10.1f");
+    print_value(out , has_dram , record->dram_bytes / 1048576.0 , session->imc_available ? "%10.2f" : "%9.2f~");
+    print_value(out , has_dram && record->ms > 0.0 , record->dram_bytes / (record->ms * 1.0e6) , "%10.2f");
+    print_value(out , record->flops > 0.0 && record->ms > 0.0 , record->flops / (record->ms * 1.0e6) , "%10.3f");
+    print_value(out , has_dram && record->flops > 0.0 , record->dram_bytes / (record->flops > 0.0 ? record->flops : 1.0) , "%10.3f");
+    print_value(out , record->flops > 0.0 , record->bytes / (record->flops > 0.0 ? record->flops : 1.0) , "%10.3f");
+    fprintf(out , "\n");
+}
+
+static void print_header(FILE *out , const char *title)
+{
+    fprintf(out , "\n%s\n", title);
+    fprintf(out , "%-30s %9s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "region" , "ms" , "cpu ms" , "Mcycles" ,
+            "Minstr" , "IPC" , "K LLC miss" , "DRAM MB" , "DRAM GB/s" , "GFLOP/s" , "B/flop" , "nominal");
+}
+
+/*
+    1. Per launch: every record in order , labelled name#launch.
+    2. Per kernel: the records of each name summed , so rates and ratios are over all of its launches. Launch #0 is left out
+       when there are later ones: it pays the one off costs (first touch of the buffers , a program build not warmed up) that
+       would otherwise skew the steady state. The label gives the range summed , e.g. name#1-4.
+    3. cpu ms / ms is the number of cores that were busy on average.
+*/
+void perf_report(const perf_session *session , FILE *out)
+{
+    char label[PERF_NAME_LEN + 16];
+
+    print_header(out , "Per launch");
+    for(int r = 0 ; r < session->num_records ; r++)
+    {
+        snprintf(label , sizeof(label) , "%s#%d" , session->records[r].name , session->records[r].launch);
+        print_record(session , out , &session->records[r] , label);
+    }
+
+    print_header(out , "Per kernel (launch #0 left out)");
+    for(int r = 0 ; r < session->num_records ; r++)
+    {
+        if(session->records[r].launch != 0)
+        {
+            continue;
+        }
+
+        int last = 0;
+        for(int other = r + 1 ; other < session->num_records ; other++)
+        {
+            if(strcmp(session->records[other].name , session->records[r].name) == 0)
+            {
+                last = session->records[other].launch;
+            }
+        }
+        int first = last > 0 ? 1 : 0;
+
+        perf_record total;
+        memset(&total , 0 , sizeof(total));
+        for(int other = r ; other < session->num_records ; other++)
+        {
+            const perf_record *record = &session->records[other];
+            if(record->launch < first || strcmp(record->name , session->records[r].name) != 0)
+            {
+                continue;
+            }
+            total.ms += record->ms;
+            for(int c = 0 ; c < PERF_NUM_COUNTERS ; c++)
+            {
+                total.counts[c] += record->counts[c];
+            }
+            total.dram_bytes += record->dram_bytes;
+            total.bytes += record->bytes;
+            total.flops += record->flops;
+        }
+
+        if(first == last)
+        {
+            snprintf(label , sizeof(label) , "%s#%d" , session->records[r].name , first);
+        }
+        else
+        {
+            snprintf(label , sizeof(label) , "%s#%d-%d" , session->records[r].name , first , last);
+        }
+        print_record(session , out , &total , label);
+    }
+    fprintf(out , "\nB/flop: measured DRAM bytes per flop. nominal: bytes the algorithm must move per flop.%s\n",
+            session->imc_available ? "" : " ~: estimated from LLC misses.");
+}
@@ -0,0 +1,93 @@
+/*
+
+Hardware Performance Counters
+-----------------------------
+
+1. On a CPU device the kernels run on host cores , in worker threads owned by the OpenCL runtime. Event timestamps say how long
+   a launch took , not whether it was limited by memory or by arithmetic. A perf_session counts , with Linux perf_event_open:
+       task-clock     CPU time of all threads (works without hardware counters , e.g. in most VMs)
+       cycles , instructions , LLC misses    per thread , user space only
+       DRAM traffic   CAS reads and writes of the integrated memory controllers (uncore_imc) , when the PMU exposes them
+2. Counters are opened on every thread in /proc/self/task , so the runtime's workers are included. New threads are picked up
+   at the start of each region. A thread that starts and exits inside one region is missed.
+3. A region is what happens between perf_region_begin and perf_region_end. perf_region_end waits for the queue first , so
+   launches and transfers inside a region are measured to completion. This serializes the queue: an instrumentation mode ,
+   not something to leave on.
+4. Each region becomes a record with its name , launch number , counts and the caller's nominal bytes and flops (0 for a
+   transfer or an integer kernel , whose GFLOP/s and B/flop then read n/a).
+   perf_report prints every record and then one line per name , summed over every launch but #0 (see perf_report) , with:
+       IPC           instructions / cycles
+       DRAM bytes    IMC counts x 64 , or LLC misses x 64 (marked ~) when the IMC is not readable. Misses undercount
+                     prefetched lines , so the estimate is a lower bound.
+       B/flop        DRAM bytes per flop. Its inverse is the arithmetic intensity of the roofline model: the kernel is memory
+                     bound when B/flop is above peak bandwidth / peak flop rate of the machine.
+5. Counters that cannot be opened (perf_event_paranoid , no PMU , not Linux) read n/a. perf_session_init never exits , it returns
+   0 when not even task-clock is available.
+6. The IMC counters are system wide (they see other processes too) and need perf_event_paranoid <= 0 or CAP_PERFMON.
+
+*/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+
+#include "kernel_cache.h"
+
+#define PERF_MAX_THREADS 256
+#define PERF_MAX_IMC 32
+#define PERF_NAME_LEN 48
+#define PERF_LINE_BYTES 64
+
+typedef enum
+{
+    PERF_TASK_CLOCK,
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_NUM_COUNTERS
+} perf_counter;
+
+typedef struct
+{
+    char name[PERF_NAME_LEN];
+    int launch;                         // 0 for the first region with this name , 1 for the next ...
+    double ms;                          // wall time
+    double counts[PERF_NUM_COUNTERS];   // task-clock in ns
+    double dram_bytes;
+    double bytes;                       // nominal bytes moved , from the caller
+    double flops;                       // nominal floating point operations , from the caller
+} perf_record;
+
+typedef struct
+{
+    int counter_available[PERF_NUM_COUNTERS];
+    int imc_available;
+
+    int num_threads;
+    int tids[PERF_MAX_THREADS];
+    int fds[PERF_MAX_THREADS][PERF_NUM_COUNTERS];
+    int num_imc;
+    int imc_fds[PERF_MAX_IMC];
+
+    double start_counts[PERF_NUM_COUNTERS];
+    double start_imc;
+    double start_ms;
+
+    perf_record *records;
+    int num_records;
+    int capacity;
+} perf_session;
+
+// Prints which counters opened to out (unless NULL). Returns 1 when at least task-clock could be opened
+int perf_session_init(perf_session *session , FILE *out);
+void perf_session_release(perf_session *session);
+
+void perf_region_begin(perf_session *session);
+
+// Waits for queue (unless NULL) , then records the counts since perf_region_begin under name
+void perf_region_end(perf_session *session , cl_command_queue queue , const char *name , double bytes , double flops);
+
+void perf_report(const perf_session *session , FILE *out);
+
+#endif
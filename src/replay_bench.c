@@ -0,0 +1,214 @@
+/*
+
+Launch Replay Benchmark
+-----------------------
+
+1. A sequence of SEQ_LEN add_arrays launches (kernel_compute.cl) ping-pongs between two buffers, x = x + b , and ends with a copy
+   of the result into an output buffer. The arrays are small, so host launch overhead dominates.
+2. "direct" is the pattern of queue_kernel() and mat_vec.c: clSetKernelArg for every argument, then clEnqueueNDRangeKernel.
+3. "replay" records the sequence once with cmd_record.h and replays it. It is measured with the emulated path, with
+   cl_khr_command_buffer when the device has it, and with two alternating buffer sets to include rebinding.
+4. Launch rates are wall clock, including a clFinish at the end of each run.
+5. The exit code is the number of runs whose output does not match.
+
+Build:
+    gcc replay_bench.c cmd_record.c bench_common.c kernel_cache.c verify.c thread_pool.c -o replay_bench -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_common.h"
+#include "cmd_record.h"
+#include "verify.h"
+
+#define PROGRAM_FILE "kernel_compute.cl"
+#define KERNEL_FUNC "add_arrays"
+#define ARRAY_SIZE 1024
+#define SEQ_LEN 8
+#define NUM_ITERATIONS 2000
+#define NUM_SLOTS 4
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void report_rate(const char *name , double seconds)
+{
+    double launches = (double)NUM_ITERATIONS * SEQ_LEN;
+    printf("%-28s %12.0f launches/s %10.2f us per sequence\n", name , launches / seconds , seconds / NUM_ITERATIONS * 1.0e6);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void run_direct(cl_command_queue queue , cl_kernel kernel , const cl_mem *slots)
+{
+    size_t global_size = ARRAY_SIZE;
+
+    for(int i = 0 ; i < SEQ_LEN ; i++)
+    {
+        clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &slots[i % 2]);
+        clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &slots[2]);
+        clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &slots[(i + 1) % 2]);
+        clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , NULL);
+    }
+    clEnqueueCopyBuffer(queue , slots[SEQ_LEN % 2] , slots[3] , 0 , 0 , ARRAY_SIZE * sizeof(float) , 0 , NULL , NULL);
+}
+
+static void record_sequence(cmd_recording *rec , cl_kernel kernel)
+{
+    size_t global_size = ARRAY_SIZE;
+
+    for(int i = 0 ; i < SEQ_LEN ; i++)
+    {
+        cmd_arg args[3] = {CMD_ARG_SLOT(i % 2) , CMD_ARG_SLOT(2) , CMD_ARG_SLOT((i + 1) % 2)};
+        if(cmd_record_kernel(rec , kernel , 1 , &global_size , NULL , 3 , args) != CL_SUCCESS)
+        {
+            printf("Couldn't record the kernel launch\n");
+            exit(1);
+        }
+    }
+    cmd_record_copy(rec , SEQ_LEN % 2 , 3 , 0 , 0 , ARRAY_SIZE * sizeof(float));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Returns 1 when the output does not match
+static int check_output(const char *name , cl_command_queue queue , const cl_mem *slots , const float *x , const float *b)
+{
+    float expected[ARRAY_SIZE] , result[ARRAY_SIZE];
+    verify_report report;
+
+    clEnqueueReadBuffer(queue , slots[3] , CL_TRUE , 0 , sizeof(result) , result , 0 , NULL , NULL);
+    for(int i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        expected[i] = x[i];
+        for(int step = 0 ; step < SEQ_LEN ; step++)
+        {
+            expected[i] += b[i];
+        }
+    }
+
+    int ok = verify_compare(NULL , expected , result , ARRAY_SIZE , VERIFY_DEFAULT_TOLERANCE , &report);
+    verify_print(name , &report);
+    return !ok;
+}
+
+static void reset_input(cl_command_queue queue , const cl_mem *slots , const float *x)
+{
+    clEnqueueWriteBuffer(queue , slots[0] , CL_TRUE , 0 , ARRAY_SIZE * sizeof(float) , x , 0 , NULL , NULL);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    cl_mem set_a[NUM_SLOTS] , set_b[NUM_SLOTS];
+    float x[ARRAY_SIZE] , b[ARRAY_SIZE];
+    double start;
+    int failures = 0;
+
+    bench_init(&bench , 0);
+    cl_kernel kernel = kernel_cache_get(&bench.cache , PROGRAM_FILE , KERNEL_FUNC , NULL);
+
+    for(int i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        x[i] = i * 1.0f;
+        b[i] = 0.5f;
+    }
+
+    for(int s = 0 ; s < NUM_SLOTS ; s++)
+    {
+        set_a[s] = clCreateBuffer(bench.context , CL_MEM_READ_WRITE , sizeof(x) , NULL , &err);
+        set_b[s] = clCreateBuffer(bench.context , CL_MEM_READ_WRITE , sizeof(x) , NULL , &err);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the buffers");
+        exit(1);
+    }
+    clEnqueueWriteBuffer(bench.queue , set_a[2] , CL_TRUE , 0 , sizeof(b) , b , 0 , NULL , NULL);
+    clEnqueueWriteBuffer(bench.queue , set_b[2] , CL_TRUE , 0 , sizeof(b) , b , 0 , NULL , NULL);
+
+    printf("%d launches of %s on %d floats per sequence , %d sequences\n\n", SEQ_LEN , KERNEL_FUNC , ARRAY_SIZE , NUM_ITERATIONS);
+
+    // Direct launches
+    reset_input(bench.queue , set_a , x);
+    run_direct(bench.queue , kernel , set_a);
+    clFinish(bench.queue);
+    failures += check_output("direct" , bench.queue , set_a , x , b);
+
+    start = bench_now_ms();
+    for(int iter = 0 ; iter < NUM_ITERATIONS ; iter++)
+    {
+        run_direct(bench.queue , kernel , set_a);
+    }
+    clFinish(bench.queue);
+    double direct_s = (bench_now_ms() - start) * 1.0e-3;
+
+    // Replay , emulated and (when available) command buffer
+    double replay_s[2] = {0.0 , 0.0};
+    double alternate_s[2] = {0.0 , 0.0};
+    int available[2] = {1 , 0};
+
+    for(int mode = 0 ; mode < 2 ; mode++)
+    {
+        cmd_recording rec;
+        const char *name = mode == 0 ? "replay (emulated)" : "replay (command buffer)";
+
+        cmd_record_init(&rec , bench.context , bench.device , bench.queue);
+        record_sequence(&rec , kernel);
+        cmd_record_finalize(&rec , mode == 0);
+
+        available[mode] = (mode == 0) || rec.use_khr;
+        if(!available[mode])
+        {
+            cmd_record_release(&rec);
+            continue;
+        }
+
+        reset_input(bench.queue , set_a , x);
+        cmd_replay(&rec , set_a , NULL);
+        clFinish(bench.queue);
+        failures += check_output(name , bench.queue , set_a , x , b);
+
+        start = bench_now_ms();
+        for(int iter = 0 ; iter < NUM_ITERATIONS ; iter++)
+        {
+            cmd_replay(&rec , set_a , NULL);
+        }
+        clFinish(bench.queue);
+        replay_s[mode] = (bench_now_ms() - start) * 1.0e-3;
+
+        start = bench_now_ms();
+        for(int iter = 0 ; iter < NUM_ITERATIONS ; iter++)
+        {
+            cmd_replay(&rec , (iter & 1) ? set_b : set_a , NULL);
+        }
+        clFinish(bench.queue);
+        alternate_s[mode] = (bench_now_ms() - start) * 1.0e-3;
+
+        cmd_record_release(&rec);
+    }
+
+    printf("\n");
+    report_rate("direct" , direct_s);
+    report_rate("replay (emulated)" , replay_s[0]);
+    report_rate("replay (emulated , 2 sets)" , alternate_s[0]);
+    if(available[1])
+    {
+        report_rate("replay (command buffer)" , replay_s[1]);
+        report_rate("replay (cmd buffer , 2 sets)" , alternate_s[1]);
+    }
+    else
+    {
+        printf("cl_khr_command_buffer 0.9.5+ not available on this device\n");
+    }
+    printf("\n%d check(s) failed.\n", failures);
+
+    for(int s = 0 ; s < NUM_SLOTS ; s++)
+    {
+        clReleaseMemObject(set_a[s]);
+        clReleaseMemObject(set_b[s]);
+    }
+    bench_release(&bench);
+
+    return failures;
+}
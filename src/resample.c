@@ -0,0 +1,460 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "resample.h"
+
+static cl_image_format image_format(int channels)
+{
+    cl_image_format format;
+    format.image_channel_order = channels == 1 ? CL_R : CL_RGBA;
+    format.image_channel_data_type = CL_UNORM_INT8;
+    return format;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int resample_image_supported(cl_context context , cl_device_id device , int channels)
+{
+    cl_bool images = CL_FALSE;
+    cl_image_format formats[128];
+    cl_uint num_formats = 0;
+
+    clGetDeviceInfo(device , CL_DEVICE_IMAGE_SUPPORT , sizeof(images) , &images , NULL);
+    if(images != CL_TRUE || (channels != 1 && channels != 4))
+    {
+        return 0;
+    }
+
+    // Reading and writing happen in different kernels , so the format must be usable both ways
+    cl_image_format wanted = image_format(channels);
+    if(clGetSupportedImageFormats(context , CL_MEM_READ_WRITE , CL_MEM_OBJECT_IMAGE2D , 128 , formats , &num_formats) != CL_SUCCESS)
+    {
+        return 0;
+    }
+    for(cl_uint i = 0 ; i < num_formats && i < 128 ; i++)
+    {
+        if(formats[i].image_channel_order == wanted.image_channel_order &&
+           formats[i].image_channel_data_type == wanted.image_channel_data_type)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int use_images(cl_context context , cl_device_id device , int channels , resample_path path)
+{
+    if(path == RESAMPLE_BUFFER)
+    {
+        return 0;
+    }
+    return resample_image_supported(context , device , channels);
+}
+
+static cl_mem create_image(cl_context context , int width , int height , int channels , cl_int *err)
+{
+    cl_image_format format = image_format(channels);
+    cl_image_desc desc;
+
+    memset(&desc , 0 , sizeof(desc));
+    desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+    desc.image_width = width;
+    desc.image_height = height;
+    return clCreateImage(context , CL_MEM_READ_WRITE , &format , &desc , NULL , err);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int resample_frame_create(resample_frame *frame , cl_context context , cl_device_id device , int width , int height , int channels ,
+                             resample_path path)
+{
+    cl_int err;
+
+    memset(frame , 0 , sizeof(*frame));
+    if(width < 1 || height < 1 || channels < 1 || channels > 4)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    frame->is_image = use_images(context , device , channels , path);
+    if(path == RESAMPLE_IMAGE && !frame->is_image)
+    {
+        return CL_IMAGE_FORMAT_NOT_SUPPORTED;
+    }
+    frame->width = width;
+    frame->height = height;
+    frame->channels = channels;
+
+    if(frame->is_image)
+    {
+        frame->mem = create_image(context , width , height , channels , &err);
+    }
+    else
+    {
+        frame->mem = clCreateBuffer(context , CL_MEM_READ_WRITE , (size_t)width * height * channels , NULL , &err);
+    }
+    if(err < 0)
+    {
+        frame->mem = NULL;
+    }
+    return err;
+}
+
+void resample_frame_release(resample_frame *frame)
+{
+    if(frame->mem != NULL)
+    {
+        clReleaseMemObject(frame->mem);
+    }
+    memset(frame , 0 , sizeof(*frame));
+}
+
+cl_int resample_frame_write(cl_command_queue queue , resample_frame *frame , const void *pixels)
+{
+    size_t origin[3] = {0 , 0 , 0};
+    size_t region[3] = {frame->width , frame->height , 1};
+
+    if(frame->is_image)
+    {
+        return clEnqueueWriteImage(queue , frame->mem , CL_TRUE , origin , region , 0 , 0 , pixels , 0 , NULL , NULL);
+    }
+    return clEnqueueWriteBuffer(queue , frame->mem , CL_TRUE , 0 , (size_t)frame->width * frame->height * frame->channels , pixels ,
+                                0 , NULL , NULL);
+}
+
+cl_int resample_frame_read(cl_command_queue queue , const resample_frame *frame , void *pixels)
+{
+    size_t origin[3] = {0 , 0 , 0};
+    size_t region[3] = {frame->width , frame->height , 1};
+
+    if(frame->is_image)
+    {
+        return clEnqueueReadImage(queue , frame->mem , CL_TRUE , origin , region , 0 , 0 , pixels , 0 , NULL , NULL);
+    }
+    return clEnqueueReadBuffer(queue , frame->mem , CL_TRUE , 0 , (size_t)frame->width * frame->height * frame->channels , pixels ,
+                               0 , NULL , NULL);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_kernel get_kernel(kernel_cache *cache , const char *kernel_name , int is_image , int channels)
+{
+    char options[32];
+
+    // Image kernels work on float4 whatever the channel count , one variant serves all
+    snprintf(options , sizeof(options) , "-DCHANNELS=%d" , is_image ? 4 : channels);
+    return kernel_cache_get(cache , RESAMPLE_PROGRAM , kernel_name , options);
+}
+
+static cl_int enqueue_2d(cl_command_queue queue , cl_kernel kernel , int width , int height , cl_event *event)
+{
+    size_t local_size[2] = {RESAMPLE_TILE , RESAMPLE_TILE};
+    size_t global_size[2] = {(width + RESAMPLE_TILE - 1) / RESAMPLE_TILE * RESAMPLE_TILE ,
+                             (height + RESAMPLE_TILE - 1) / RESAMPLE_TILE * RESAMPLE_TILE};
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
+
+// Image kernels take (in , out). Buffer kernels take (in , [in_offset ,] out , [out_offset ,] in_w , in_h , out_w , out_h).
+static cl_int launch_frames(kernel_cache *cache , cl_command_queue queue , const char *buffer_kernel , const char *image_kernel ,
+                            int with_offsets , const resample_frame *in , resample_frame *out , cl_event *event)
+{
+    cl_kernel kernel;
+    cl_int err;
+    int zero = 0;
+    int arg = 0;
+
+    if(in->is_image != out->is_image)
+    {
+        return CL_INVALID_MEM_OBJECT;
+    }
+    if(in->channels != out->channels)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    kernel = get_kernel(cache , in->is_image ? image_kernel : buffer_kernel , in->is_image , in->channels);
+    err = clSetKernelArg(kernel , arg++ , sizeof(cl_mem) , &in->mem);
+    if(!in->is_image && with_offsets)
+    {
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &zero);
+    }
+    err |= clSetKernelArg(kernel , arg++ , sizeof(cl_mem) , &out->mem);
+    if(!in->is_image)
+    {
+        if(with_offsets)
+        {
+            err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &zero);
+        }
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &in->width);
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &in->height);
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &out->width);
+        err |= clSetKernelArg(kernel , arg++ , sizeof(int) , &out->height);
+    }
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    return enqueue_2d(queue , kernel , out->width , out->height , event);
+}
+
+cl_int launch_pyr_down(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out , cl_event *event)
+{
+    if(out->width != (in->width + 1) / 2 || out->height != (in->height + 1) / 2)
+    {
+        return CL_INVALID_IMAGE_SIZE;
+    }
+    return launch_frames(cache , queue , "pyrDownBuf" , "pyrDownImg" , 1 , in , out , event);
+}
+
+cl_int launch_pyr_up(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out , cl_event *event)
+{
+    if((out->width != 2 * in->width && out->width != 2 * in->width - 1) ||
+       (out->height != 2 * in->height && out->height != 2 * in->height - 1))
+    {
+        return CL_INVALID_IMAGE_SIZE;
+    }
+    return launch_frames(cache , queue , "pyrUpBuf" , "pyrUpImg" , 1 , in , out , event);
+}
+
+// The area kernels interpolate bilinearly along an axis that grows , so a mixed resize (one axis shrinks , the other grows)
+// stays smooth. When both axes grow the result is plain bilinear , and the bilinear kernel computes it more cheaply.
+cl_int launch_resize(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out ,
+                     resize_method method , cl_event *event)
+{
+    if(method == RESIZE_AREA && (out->width < in->width || out->height < in->height))
+    {
+        return launch_frames(cache , queue , "resizeAreaBuf" , "resizeAreaImg" , 0 , in , out , event);
+    }
+    return launch_frames(cache , queue , "resizeBilinearBuf" , "resizeBilinearImg" , 0 , in , out , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int pyramid_create(pyramid *pyr , cl_context context , cl_device_id device , int width , int height , int channels , int num_levels ,
+                      resample_path path)
+{
+    cl_int err = CL_SUCCESS;
+    size_t total = 0;
+
+    memset(pyr , 0 , sizeof(*pyr));
+    if(width < 1 || height < 1 || channels < 1 || channels > 4 || num_levels < 0 || num_levels > PYRAMID_MAX_LEVELS)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    pyr->is_image = use_images(context , device , channels , path);
+    if(path == RESAMPLE_IMAGE && !pyr->is_image)
+    {
+        return CL_IMAGE_FORMAT_NOT_SUPPORTED;
+    }
+    pyr->channels = channels;
+
+    int max_levels = num_levels > 0 ? num_levels : PYRAMID_MAX_LEVELS;
+    pyr->first_tail = max_levels;
+    for(int level = 0 ; level < max_levels ; level++)
+    {
+        pyr->width[level] = width;
+        pyr->height[level] = height;
+        pyr->offset[level] = total;
+        pyr->num_levels = level + 1;
+        total += (size_t)width * height * channels;
+
+        if(level > 0 && pyr->first_tail == max_levels && width * height <= PYRAMID_TAIL_PIXELS)
+        {
+            pyr->first_tail = level;
+        }
+        if(num_levels == 0 && width == 1 && height == 1)
+        {
+            break;
+        }
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    if(pyr->first_tail > pyr->num_levels)
+    {
+        pyr->first_tail = pyr->num_levels;
+    }
+
+    if(!pyr->is_image)
+    {
+        // The tail kernel addresses levels with int offsets
+        if(total > 0x7fffffff)
+        {
+            return CL_INVALID_BUFFER_SIZE;
+        }
+        pyr->levels = clCreateBuffer(context , CL_MEM_READ_WRITE , total , NULL , &err);
+        if(err < 0)
+        {
+            pyr->levels = NULL;
+        }
+        return err;
+    }
+
+    for(int level = 0 ; level < pyr->num_levels ; level++)
+    {
+        pyr->images[level] = create_image(context , pyr->width[level] , pyr->height[level] , channels , &err);
+        if(err < 0)
+        {
+            pyr->images[level] = NULL;
+            pyramid_release(pyr);
+            return err;
+        }
+    }
+    return CL_SUCCESS;
+}
+
+void pyramid_release(pyramid *pyr)
+{
+    if(pyr->levels != NULL)
+    {
+        clReleaseMemObject(pyr->levels);
+    }
+    for(int level = 0 ; level < PYRAMID_MAX_LEVELS ; level++)
+    {
+        if(pyr->images[level] != NULL)
+        {
+            clReleaseMemObject(pyr->images[level]);
+        }
+    }
+    memset(pyr , 0 , sizeof(*pyr));
+}
+
+// A frame view of one level , for the copy and the image kernels
+static resample_frame level_frame(const pyramid *pyr , int level)
+{
+    resample_frame frame;
+    frame.mem = pyr->is_image ? pyr->images[level] : pyr->levels;
+    frame.is_image = pyr->is_image;
+    frame.width = pyr->width[level];
+    frame.height = pyr->height[level];
+    frame.channels = pyr->channels;
+    return frame;
+}
+
+static cl_int copy_base(cl_command_queue queue , pyramid *pyr , const resample_frame *src)
+{
+    size_t origin[3] = {0 , 0 , 0};
+    size_t region[3] = {pyr->width[0] , pyr->height[0] , 1};
+    size_t bytes = (size_t)pyr->width[0] * pyr->height[0] * pyr->channels;
+
+    if(src->width != pyr->width[0] || src->height != pyr->height[0] || src->channels != pyr->channels)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    if(src->is_image && pyr->is_image)
+    {
+        return clEnqueueCopyImage(queue , src->mem , pyr->images[0] , origin , origin , region , 0 , NULL , NULL);
+    }
+    if(src->is_image)
+    {
+        return clEnqueueCopyImageToBuffer(queue , src->mem , pyr->levels , origin , region , 0 , 0 , NULL , NULL);
+    }
+    if(pyr->is_image)
+    {
+        return clEnqueueCopyBufferToImage(queue , src->mem , pyr->images[0] , 0 , origin , region , 0 , NULL , NULL);
+    }
+    return clEnqueueCopyBuffer(queue , src->mem , pyr->levels , 0 , 0 , bytes , 0 , NULL , NULL);
+}
+
+/*
+    1. Every level only depends on the one before , and the launches go to the same in-order queue , so they are enqueued
+       back to back without waiting. Nothing is read back until the caller asks for a level.
+    2. Buffer path: levels 1 .. first_tail - 1 get a launch each , the rest one launch of a single work-group.
+*/
+cl_int launch_pyramid(kernel_cache *cache , cl_command_queue queue , pyramid *pyr , const resample_frame *src , cl_event *event)
+{
+    cl_kernel kernel;
+    cl_int err = CL_SUCCESS;
+
+    if(src != NULL)
+    {
+        err = copy_base(queue , pyr , src);
+        if(err != CL_SUCCESS)
+        {
+            return err;
+        }
+    }
+
+    if(pyr->num_levels == 1)
+    {
+        return event != NULL ? clEnqueueMarkerWithWaitList(queue , 0 , NULL , event) : CL_SUCCESS;
+    }
+
+    if(pyr->is_image)
+    {
+        for(int level = 1 ; level < pyr->num_levels && err == CL_SUCCESS ; level++)
+        {
+            resample_frame in = level_frame(pyr , level - 1);
+            resample_frame out = level_frame(pyr , level);
+            err = launch_frames(cache , queue , "pyrDownBuf" , "pyrDownImg" , 1 , &in , &out ,
+                                level == pyr->num_levels - 1 ? event : NULL);
+        }
+        return err;
+    }
+
+    kernel = get_kernel(cache , "pyrDownBuf" , 0 , pyr->channels);
+    for(int level = 1 ; level < pyr->first_tail ; level++)
+    {
+        int in_offset = (int)pyr->offset[level - 1];
+        int out_offset = (int)pyr->offset[level];
+
+        err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &pyr->levels);
+        err |= clSetKernelArg(kernel , 1 , sizeof(int) , &in_offset);
+        err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &pyr->levels);
+        err |= clSetKernelArg(kernel , 3 , sizeof(int) , &out_offset);
+        err |= clSetKernelArg(kernel , 4 , sizeof(int) , &pyr->width[level - 1]);
+        err |= clSetKernelArg(kernel , 5 , sizeof(int) , &pyr->height[level - 1]);
+        err |= clSetKernelArg(kernel , 6 , sizeof(int) , &pyr->width[level]);
+        err |= clSetKernelArg(kernel , 7 , sizeof(int) , &pyr->height[level]);
+        if(err == CL_SUCCESS)
+        {
+            err = enqueue_2d(queue , kernel , pyr->width[level] , pyr->height[level] ,
+                             level == pyr->num_levels - 1 ? event : NULL);
+        }
+        if(err != CL_SUCCESS)
+        {
+            return err;
+        }
+    }
+
+    if(pyr->first_tail == pyr->num_levels)
+    {
+        return CL_SUCCESS;
+    }
+
+    int tail_levels = pyr->num_levels - pyr->first_tail;
+    int in_offset = (int)pyr->offset[pyr->first_tail - 1];
+    kernel = get_kernel(cache , "pyrDownTail" , 0 , pyr->channels);
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &pyr->levels);
+    err |= clSetKernelArg(kernel , 1 , sizeof(int) , &in_offset);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &pyr->width[pyr->first_tail - 1]);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &pyr->height[pyr->first_tail - 1]);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &tail_levels);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t tail_size = PYRAMID_TAIL_GROUP;
+    return clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &tail_size , &tail_size , 0 , NULL , event);
+}
+
+cl_int pyramid_write_base(cl_command_queue queue , pyramid *pyr , const void *pixels)
+{
+    resample_frame base = level_frame(pyr , 0);
+    return resample_frame_write(queue , &base , pixels);
+}
+
+cl_int pyramid_read_level(cl_command_queue queue , const pyramid *pyr , int level , void *pixels)
+{
+    if(level < 0 || level >= pyr->num_levels)
+    {
+        return CL_INVALID_VALUE;
+    }
+    if(pyr->is_image)
+    {
+        resample_frame frame = level_frame(pyr , level);
+        return resample_frame_read(queue , &frame , pixels);
+    }
+    return clEnqueueReadBuffer(queue , pyr->levels , CL_TRUE , pyr->offset[level] ,
+                               (size_t)pyr->width[level] * pyr->height[level] * pyr->channels , pixels , 0 , NULL , NULL);
+}
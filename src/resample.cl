@@ -0,0 +1,364 @@
+/*
+    Image pyramids and resizing of interleaved 8-bit images. Built by resample.c with -D CHANNELS (1 to 4) for the buffer kernels.
+
+    1. Buffer kernels (*Buf) address pixels as uchar arrays at an offset , so all levels of a pyramid can share one buffer.
+       Image kernels (*Img) read image2d_t objects (CL_R or CL_RGBA , CL_UNORM_INT8) through the texture units.
+    2. Reduce is the 5x5 Gaussian [1 4 6 4 1] / 16 in each direction , evaluated at every other pixel.
+       Expand inserts zeros between the pixels and filters with the same taps times 2 per direction.
+    3. The image path lets the sampler's bilinear filtering merge neighbouring taps: reduce needs 3x3 fetches instead of 5x5 ,
+       expand at most 2x2 , and a bilinear resize a single fetch. The filtering hardware rounds its weights , so results can differ
+       from the buffer path by a level.
+    4. Every kernel clamps at the borders (the edge pixel repeats).
+    5. Bilinear resize maps pixel centres: source = (x + 0.5) * in_w / out_w - 0.5. Area resize averages the source pixels
+       covered by each output pixel , weighted by the covered fraction. The weights are separable , so each axis is handled on
+       its own: on an axis that grows (scale < 1) an output pixel covers less than one source pixel , and the area kernels use
+       the bilinear weights along it instead.
+*/
+
+#ifndef CHANNELS
+#define CHANNELS 1
+#endif
+
+__constant float gauss5[5] = {1.0f , 4.0f , 6.0f , 4.0f , 1.0f};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Buffer path
+inline void pyr_down_pixel(__global const uchar *pIn , __global uchar *pOut , int in_w , int in_h , int out_w , int x , int y)
+{
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    for(int dy = -2 ; dy <= 2 ; dy++)
+    {
+        int sy = clamp(2 * y + dy , 0 , in_h - 1);
+        for(int dx = -2 ; dx <= 2 ; dx++)
+        {
+            int sx = clamp(2 * x + dx , 0 , in_w - 1);
+            float w = gauss5[dy + 2] * gauss5[dx + 2];
+            for(int c = 0 ; c < CHANNELS ; c++)
+            {
+                sum[c] += w * pIn[(sy * in_w + sx) * CHANNELS + c];
+            }
+        }
+    }
+
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pOut[(y * out_w + x) * CHANNELS + c] = convert_uchar_sat_rte(sum[c] * (1.0f / 256.0f));
+    }
+}
+
+__kernel void pyrDownBuf(__global const uchar *pIn , int in_offset , __global uchar *pOut , int out_offset ,
+                         int in_w , int in_h , int out_w , int out_h)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x < out_w && y < out_h)
+    {
+        pyr_down_pixel(pIn + in_offset , pOut + out_offset , in_w , in_h , out_w , x , y);
+    }
+}
+
+/*
+    The small levels at the end of a pyramid keep few work-items busy , and each launch costs more than the work.
+    A single work-group computes num_levels levels one after the other. The levels are packed in one buffer ,
+    level l + 1 starting right after level l. The barrier makes the writes of one level visible before the next reads them.
+*/
+__kernel void pyrDownTail(__global uchar *pLevels , int in_offset , int in_w , int in_h , int num_levels)
+{
+    int lid = get_local_id(0);
+    int group_size = get_local_size(0);
+
+    for(int level = 0 ; level < num_levels ; level++)
+    {
+        int out_w = (in_w + 1) / 2;
+        int out_h = (in_h + 1) / 2;
+        int out_offset = in_offset + in_w * in_h * CHANNELS;
+
+        for(int i = lid ; i < out_w * out_h ; i += group_size)
+        {
+            pyr_down_pixel(pLevels + in_offset , pLevels + out_offset , in_w , in_h , out_w , i % out_w , i / out_w);
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        in_offset = out_offset;
+        in_w = out_w;
+        in_h = out_h;
+    }
+}
+
+__kernel void pyrUpBuf(__global const uchar *pIn , int in_offset , __global uchar *pOut , int out_offset ,
+                       int in_w , int in_h , int out_w , int out_h)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x >= out_w || y >= out_h)
+    {
+        return;
+    }
+
+    pIn += in_offset;
+    pOut += out_offset;
+
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    // Source pixels whose upsampled position 2 * s is within 2 of the output pixel
+    for(int sy = (y - 1) >> 1 ; sy <= (y + 2) >> 1 ; sy++)
+    {
+        float wy = gauss5[y - 2 * sy + 2];
+        int cy = clamp(sy , 0 , in_h - 1);
+        for(int sx = (x - 1) >> 1 ; sx <= (x + 2) >> 1 ; sx++)
+        {
+            float w = wy * gauss5[x - 2 * sx + 2];
+            int cx = clamp(sx , 0 , in_w - 1);
+            for(int c = 0 ; c < CHANNELS ; c++)
+            {
+                sum[c] += w * pIn[(cy * in_w + cx) * CHANNELS + c];
+            }
+        }
+    }
+
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pOut[(y * out_w + x) * CHANNELS + c] = convert_uchar_sat_rte(sum[c] * (1.0f / 64.0f));
+    }
+}
+
+__kernel void resizeBilinearBuf(__global const uchar *pIn , __global uchar *pOut , int in_w , int in_h , int out_w , int out_h)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x >= out_w || y >= out_h)
+    {
+        return;
+    }
+
+    float fx = (x + 0.5f) * ((float)in_w / out_w) - 0.5f;
+    float fy = (y + 0.5f) * ((float)in_h / out_h) - 0.5f;
+    int x0 = (int)floor(fx);
+    int y0 = (int)floor(fy);
+    float wx = fx - x0;
+    float wy = fy - y0;
+    int x1 = clamp(x0 + 1 , 0 , in_w - 1);
+    int y1 = clamp(y0 + 1 , 0 , in_h - 1);
+    x0 = clamp(x0 , 0 , in_w - 1);
+    y0 = clamp(y0 , 0 , in_h - 1);
+
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        float top = mix((float)pIn[(y0 * in_w + x0) * CHANNELS + c] , (float)pIn[(y0 * in_w + x1) * CHANNELS + c] , wx);
+        float bottom = mix((float)pIn[(y1 * in_w + x0) * CHANNELS + c] , (float)pIn[(y1 * in_w + x1) * CHANNELS + c] , wx);
+        pOut[(y * out_w + x) * CHANNELS + c] = convert_uchar_sat_rte(mix(top , bottom , wy));
+    }
+}
+
+/*
+    Source pixels lo .. hi - 1 that contribute to output pixel x along one axis , and the bounds area_weight needs.
+    A shrinking axis covers [start , end). A growing axis interpolates around start (= end) , lo may be -1 and hi may be
+    in_size , so callers clamp the index they read.
+*/
+inline void area_span(int x , float scale , int in_size , float *start , float *end , int *lo , int *hi)
+{
+    if(scale >= 1.0f)
+    {
+        *start = x * scale;
+        *end = min((x + 1) * scale , (float)in_size);
+        *lo = (int)*start;
+        *hi = (int)ceil(*end);
+    }
+    else
+    {
+        *start = (x + 0.5f) * scale - 0.5f;
+        *end = *start;
+        *lo = (int)floor(*start);
+        *hi = *lo + 2;
+    }
+}
+
+// Normalized weight of source pixel s: the covered fraction when shrinking , the tent 1 - |position - s| when growing
+inline float area_weight(int s , float scale , float start , float end)
+{
+    if(scale >= 1.0f)
+    {
+        return (min(end , s + 1.0f) - max(start , (float)s)) / (end - start);
+    }
+    return max(1.0f - fabs(start - s) , 0.0f);
+}
+
+__kernel void resizeAreaBuf(__global const uchar *pIn , __global uchar *pOut , int in_w , int in_h , int out_w , int out_h)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x >= out_w || y >= out_h)
+    {
+        return;
+    }
+
+    float scale_x = (float)in_w / out_w;
+    float scale_y = (float)in_h / out_h;
+    float x_start , x_end , y_start , y_end;
+    int x_lo , x_hi , y_lo , y_hi;
+    area_span(x , scale_x , in_w , &x_start , &x_end , &x_lo , &x_hi);
+    area_span(y , scale_y , in_h , &y_start , &y_end , &y_lo , &y_hi);
+
+    float sum[CHANNELS];
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        sum[c] = 0.0f;
+    }
+
+    for(int sy = y_lo ; sy < y_hi ; sy++)
+    {
+        float wy = area_weight(sy , scale_y , y_start , y_end);
+        int cy = clamp(sy , 0 , in_h - 1);
+        for(int sx = x_lo ; sx < x_hi ; sx++)
+        {
+            float w = wy * area_weight(sx , scale_x , x_start , x_end);
+            int cx = clamp(sx , 0 , in_w - 1);
+            for(int c = 0 ; c < CHANNELS ; c++)
+            {
+                sum[c] += w * pIn[(cy * in_w + cx) * CHANNELS + c];
+            }
+        }
+    }
+
+    for(int c = 0 ; c < CHANNELS ; c++)
+    {
+        pOut[(y * out_w + x) * CHANNELS + c] = convert_uchar_sat_rte(sum[c]);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Image path. Unnormalized coordinates: the centre of pixel i is at i + 0.5.
+__constant sampler_t linear_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+__constant sampler_t nearest_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+// Taps 1 4 | 6 | 4 1 become three bilinear fetches at -1.2 , 0 , +1.2 with weights 5 , 6 , 5 (out of 16)
+__kernel void pyrDownImg(__read_only image2d_t in , __write_only image2d_t out)
+{
+    const float offsets[3] = {-1.2f , 0.0f , 1.2f};
+    const float weights[3] = {5.0f / 16.0f , 6.0f / 16.0f , 5.0f / 16.0f};
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x >= get_image_width(out) || y >= get_image_height(out))
+    {
+        return;
+    }
+
+    float4 sum = (float4)(0.0f);
+    for(int j = 0 ; j < 3 ; j++)
+    {
+        for(int i = 0 ; i < 3 ; i++)
+        {
+            float2 pos = (float2)(2 * x + 0.5f + offsets[i] , 2 * y + 0.5f + offsets[j]);
+            sum += weights[i] * weights[j] * read_imagef(in , linear_sampler , pos);
+        }
+    }
+    write_imagef(out , (int2)(x , y) , sum);
+}
+
+/*
+    Per direction , an even output pixel 2s takes source s - 1 , s , s + 1 with weights 1 , 6 , 1 (out of 8): one bilinear fetch at
+    s - 1/7 with weight 7/8 and one at s + 1 with weight 1/8. An odd pixel 2s + 1 takes s and s + 1 with 4 , 4: one fetch halfway.
+*/
+inline void expand_taps(int x , float *pos , float *weight , int *count)
+{
+    int s = x >> 1;
+    if(x & 1)
+    {
+        pos[0] = s + 1.0f;
+        weight[0] = 1.0f;
+        *count = 1;
+    }
+    else
+    {
+        pos[0] = s + 0.5f - 1.0f / 7.0f;
+        weight[0] = 7.0f / 8.0f;
+        pos[1] = s + 1.5f;
+        weight[1] = 1.0f / 8.0f;
+        *count = 2;
+    }
+}
+
+__kernel void pyrUpImg(__read_only image2d_t in , __write_only image2d_t out)
+{
+    float pos_x[2] , pos_y[2] , weight_x[2] , weight_y[2];
+    int count_x , count_y;
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if(x >= get_image_width(out) || y >= get_image_height(out))
+    {
+        return;
+    }
+
+    expand_taps(x , pos_x , weight_x , &count_x);
+    expand_taps(y , pos_y , weight_y , &count_y);
+
+    float4 sum = (float4)(0.0f);
+    for(int j = 0 ; j < count_y ; j++)
+    {
+        for(int i = 0 ; i < count_x ; i++)
+        {
+            sum += weight_x[i] * weight_y[j] * read_imagef(in , linear_sampler , (float2)(pos_x[i] , pos_y[j]));
+        }
+    }
+    write_imagef(out , (int2)(x , y) , sum);
+}
+
+__kernel void resizeBilinearImg(__read_only image2d_t in , __write_only image2d_t out)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int out_w = get_image_width(out);
+    int out_h = get_image_height(out);
+    if(x >= out_w || y >= out_h)
+    {
+        return;
+    }
+
+    float2 pos = (float2)((x + 0.5f) * get_image_width(in) / out_w , (y + 0.5f) * get_image_height(in) / out_h);
+    write_imagef(out , (int2)(x , y) , read_imagef(in , linear_sampler , pos));
+}
+
+__kernel void resizeAreaImg(__read_only image2d_t in , __write_only image2d_t out)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int in_w = get_image_width(in);
+    int in_h = get_image_height(in);
+    int out_w = get_image_width(out);
+    int out_h = get_image_height(out);
+    if(x >= out_w || y >= out_h)
+    {
+        return;
+    }
+
+    float scale_x = (float)in_w / out_w;
+    float scale_y = (float)in_h / out_h;
+    float x_start , x_end , y_start , y_end;
+    int x_lo , x_hi , y_lo , y_hi;
+    area_span(x , scale_x , in_w , &x_start , &x_end , &x_lo , &x_hi);
+    area_span(y , scale_y , in_h , &y_start , &y_end , &y_lo , &y_hi);
+
+    // The sampler clamps to the edge , so the taps of a growing axis outside the image need no clamp here
+    float4 sum = (float4)(0.0f);
+    for(int sy = y_lo ; sy < y_hi ; sy++)
+    {
+        float wy = area_weight(sy , scale_y , y_start , y_end);
+        for(int sx = x_lo ; sx < x_hi ; sx++)
+        {
+            float w = wy * area_weight(sx , scale_x , x_start , x_end);
+            sum += w * read_imagef(in , nearest_sampler , (float2)(sx + 0.5f , sy + 0.5f));
+        }
+    }
+    write_imagef(out , (int2)(x , y) , sum);
+}
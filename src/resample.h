@@ -0,0 +1,97 @@
+/*
+
+Resampling and Image Pyramids
+-----------------------------
+
+1. Shrinks and enlarges 8-bit interleaved images on the device , with 1 to 4 channels. This is the input for multi-scale work:
+   feature detection , coarse-to-fine optical flow , blending.
+2. launch_pyr_down halves an image with a 5x5 Gaussian (one level of a Gaussian pyramid). launch_pyr_up doubles it with the
+   same filter. launch_resize scales to any size , with bilinear interpolation or by averaging the covered area. Area is the
+   better choice for downscaling because it does not alias. Along an axis that grows , area interpolates bilinearly.
+3. A resample_frame is either a buffer or an image2d_t. Images are read through the texture units , and their bilinear filtering
+   merges the taps of neighbouring pixels: a reduce takes 9 fetches instead of 25. RESAMPLE_AUTO uses images when the
+   device supports them and the channel count has an 8-bit format (1 or 4 channels). Otherwise it uses buffers.
+   Hardware filtering rounds its weights , so the image path can be one level off the buffer path.
+4. launch_pyramid builds all levels of a pyramid from level 0 with no host round trip. On the buffer path the levels are
+   packed into one buffer , and every level that fits in PYRAMID_TAIL_PIXELS is computed by a single work-group in one
+   launch: those levels are too small to fill the device , so their cost would be mostly launch overhead.
+   A 1920x1080 pyramid down to 1x1 has 12 levels and takes 5 launches.
+5. Every kernel repeats the edge pixel at the borders.
+
+*/
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include "kernel_cache.h"
+
+#define RESAMPLE_PROGRAM "resample.cl"
+#define RESAMPLE_TILE 16
+#define PYRAMID_MAX_LEVELS 16
+#define PYRAMID_TAIL_PIXELS 4096
+#define PYRAMID_TAIL_GROUP 256
+
+typedef enum
+{
+    RESAMPLE_AUTO,
+    RESAMPLE_BUFFER,
+    RESAMPLE_IMAGE
+} resample_path;
+
+typedef enum
+{
+    RESIZE_BILINEAR,
+    RESIZE_AREA
+} resize_method;
+
+typedef struct
+{
+    cl_mem mem;                 // width x height x channels bytes , or an image2d_t when is_image
+    int is_image;
+    int width;
+    int height;
+    int channels;
+} resample_frame;
+
+typedef struct
+{
+    int is_image;
+    int channels;
+    int num_levels;
+    int width[PYRAMID_MAX_LEVELS];
+    int height[PYRAMID_MAX_LEVELS];
+
+    cl_mem levels;              // buffer path: all levels packed , level l at offset[l] bytes
+    size_t offset[PYRAMID_MAX_LEVELS];
+    int first_tail;             // buffer path: levels from here on are built by a single work-group
+    cl_mem images[PYRAMID_MAX_LEVELS];
+} pyramid;
+
+// True when the device can sample images with this channel count
+int resample_image_supported(cl_context context , cl_device_id device , int channels);
+
+cl_int resample_frame_create(resample_frame *frame , cl_context context , cl_device_id device , int width , int height , int channels ,
+                             resample_path path);
+void resample_frame_release(resample_frame *frame);
+cl_int resample_frame_write(cl_command_queue queue , resample_frame *frame , const void *pixels);
+cl_int resample_frame_read(cl_command_queue queue , const resample_frame *frame , void *pixels);
+
+// in and out must both be buffers or both be images , with the same channel count. The output size comes from out.
+// pyr_down: out is ((w + 1) / 2) x ((h + 1) / 2). pyr_up: out is 2w x 2h , or one less to return to an odd size.
+cl_int launch_pyr_down(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out , cl_event *event);
+cl_int launch_pyr_up(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out , cl_event *event);
+cl_int launch_resize(kernel_cache *cache , cl_command_queue queue , const resample_frame *in , resample_frame *out ,
+                     resize_method method , cl_event *event);
+
+// num_levels includes level 0. Pass 0 for levels down to 1x1.
+cl_int pyramid_create(pyramid *pyr , cl_context context , cl_device_id device , int width , int height , int channels , int num_levels ,
+                      resample_path path);
+void pyramid_release(pyramid *pyr);
+
+// Copies src (a frame of the level 0 size , on the device) into level 0 and builds the other levels.
+// src may be NULL when level 0 was filled with pyramid_write_base.
+cl_int launch_pyramid(kernel_cache *cache , cl_command_queue queue , pyramid *pyr , const resample_frame *src , cl_event *event);
+cl_int pyramid_write_base(cl_command_queue queue , pyramid *pyr , const void *pixels);
+cl_int pyramid_read_level(cl_command_queue queue , const pyramid *pyr , int level , void *pixels);
+
+#endif
@@ -0,0 +1,553 @@
+/*
+
+Resampling Benchmark
+--------------------
+
+1. Checks pyramid reduce and expand , bilinear and area resize against C implementations of the same filters , for 1 , 3 and 4 channels
+   on the buffer path and for 1 and 4 channels on the image path when the device has images. Buffer results must be within one
+   level , image results within two (the sampler rounds its interpolation weights). Area resize is also checked with one
+   axis shrinking and the other growing.
+2. Checks every level of a full pyramid built by launch_pyramid against a reduce of the level above it.
+3. Times a full 1920x1080 gray pyramid built with launch_pyramid against one launch_pyr_down call per level , on both paths.
+   The end to end column includes the launches and the wait , which is where the small levels spend their time.
+4. Times 1920x1080 resizes to 1280x720 and 480x270 on both paths.
+5. The exit code is the number of failed checks.
+
+Build:
+    gcc -O3 resample_bench.c resample.c bench_common.c kernel_cache.c -o resample_bench -lOpenCL -lm
+
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "resample.h"
+
+#define CHECK_WIDTH 157
+#define CHECK_HEIGHT 93
+#define FRAME_WIDTH 1920
+#define FRAME_HEIGHT 1080
+#define NUM_ITERATIONS 20
+
+static const float gauss5[5] = {1.0f , 4.0f , 6.0f , 4.0f , 1.0f};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void make_image(unsigned char *pixels , int width , int height , int channels)
+{
+    for(int y = 0 ; y < height ; y++)
+    {
+        for(int x = 0 ; x < width ; x++)
+        {
+            for(int c = 0 ; c < channels ; c++)
+            {
+                float v = 128.0f + 100.0f * sinf(x * (0.05f + 0.02f * c)) * cosf(y * 0.07f);
+                if(((x / 16) + (y / 16)) % 3 == 0)
+                {
+                    v = 255.0f - v;
+                }
+                pixels[((size_t)y * width + x) * channels + c] = (unsigned char)v;
+            }
+        }
+    }
+}
+
+static int clampi(int v , int lo , int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static unsigned char to_byte(float v)
+{
+    v = v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v;
+    return (unsigned char)lrintf(v);
+}
+
+// Same filters as resample.cl
+static void reference_pyr_down(const unsigned char *in , unsigned char *out , int in_w , int in_h , int channels)
+{
+    int out_w = (in_w + 1) / 2 , out_h = (in_h + 1) / 2;
+
+    for(int y = 0 ; y < out_h ; y++)
+    {
+        for(int x = 0 ; x < out_w ; x++)
+        {
+            for(int c = 0 ; c < channels ; c++)
+            {
+                float sum = 0.0f;
+                for(int dy = -2 ; dy <= 2 ; dy++)
+                {
+                    int sy = clampi(2 * y + dy , 0 , in_h - 1);
+                    for(int dx = -2 ; dx <= 2 ; dx++)
+                    {
+                        int sx = clampi(2 * x + dx , 0 , in_w - 1);
+                        sum += gauss5[dy + 2] * gauss5[dx + 2] * in[((size_t)sy * in_w + sx) * channels + c];
+                    }
+                }
+                out[((size_t)y * out_w + x) * channels + c] = to_byte(sum / 256.0f);
+            }
+        }
+    }
+}
+
+static void reference_pyr_up(const unsigned char *in , unsigned char *out , int in_w , int in_h , int out_w , int out_h , int channels)
+{
+    for(int y = 0 ; y < out_h ; y++)
+    {
+        for(int x = 0 ; x < out_w ; x++)
+        {
+            for(int c = 0 ; c < channels ; c++)
+            {
+                float sum = 0.0f;
+                for(int sy = (y - 1) >> 1 ; sy <= (y + 2) >> 1 ; sy++)
+                {
+                    for(int sx = (x - 1) >> 1 ; sx <= (x + 2) >> 1 ; sx++)
+                    {
+                        int cy = clampi(sy , 0 , in_h - 1) , cx = clampi(sx , 0 , in_w - 1);
+                        sum += gauss5[y - 2 * sy + 2] * gauss5[x - 2 * sx + 2] * in[((size_t)cy * in_w + cx) * channels + c];
+                    }
+                }
+                out[((size_t)y * out_w + x) * channels + c] = to_byte(sum / 64.0f);
+            }
+        }
+    }
+}
+
+static void reference_bilinear(const unsigned char *in , unsigned char *out , int in_w , int in_h , int out_w , int out_h , int channels)
+{
+    for(int y = 0 ; y < out_h ; y++)
+    {
+        for(int x = 0 ; x < out_w ; x++)
+        {
+            float fx = (x + 0.5f) * ((float)in_w / out_w) - 0.5f;
+            float fy = (y + 0.5f) * ((float)in_h / out_h) - 0.5f;
+            int x0 = (int)floorf(fx) , y0 = (int)floorf(fy);
+            float wx = fx - x0 , wy = fy - y0;
+            int x1 = clampi(x0 + 1 , 0 , in_w - 1) , y1 = clampi(y0 + 1 , 0 , in_h - 1);
+            x0 = clampi(x0 , 0 , in_w - 1);
+            y0 = clampi(y0 , 0 , in_h - 1);
+
+            for(int c = 0 ; c < channels ; c++)
+            {
+#define P(px , py) ((float)in[((size_t)(py) * in_w + (px)) * channels + c])
+                float top = P(x0 , y0) + (P(x1 , y0) - P(x0 , y0)) * wx;
+                float bottom = P(x0 , y1) + (P(x1 , y1) - P(x0 , y1)) * wx;
+#undef P
+                out[((size_t)y * out_w + x) * channels + c] = to_byte(top + (bottom - top) * wy);
+            }
+        }
+    }
+}
+
+// Weights of output pixel x along one axis: covered fractions when the axis shrinks , bilinear when it grows
+static int reference_area_weights(int x , int in_size , int out_size , int *first , double *weights)
+{
+    double scale = (double)in_size / out_size;
+    int count = 0;
+
+    if(scale < 1.0)
+    {
+        double pos = (x + 0.5) * scale - 0.5;
+        *first = (int)floor(pos);
+        weights[0] = 1.0 - (pos - *first);
+        weights[1] = pos - *first;
+        return 2;
+    }
+
+    double start = x * scale , end = fmin((x + 1) * scale , in_size);
+    *first = (int)start;
+    for(int s = *first ; s < end ; s++)
+    {
+        weights[count++] = (fmin(end , s + 1.0) - fmax(start , s)) / (end - start);
+    }
+    return count;
+}
+
+static void reference_area(const unsigned char *in , unsigned char *out , int in_w , int in_h , int out_w , int out_h , int channels)
+{
+    double *weights_x = (double*)malloc(sizeof(double) * (in_w / out_w + 2));
+    double *weights_y = (double*)malloc(sizeof(double) * (in_h / out_h + 2));
+    int first_x , first_y;
+
+    for(int y = 0 ; y < out_h ; y++)
+    {
+        int count_y = reference_area_weights(y , in_h , out_h , &first_y , weights_y);
+        for(int x = 0 ; x < out_w ; x++)
+        {
+            int count_x = reference_area_weights(x , in_w , out_w , &first_x , weights_x);
+            for(int c = 0 ; c < channels ; c++)
+            {
+                double sum = 0.0;
+                for(int j = 0 ; j < count_y ; j++)
+                {
+                    int sy = clampi(first_y + j , 0 , in_h - 1);
+                    for(int i = 0 ; i < count_x ; i++)
+                    {
+                        int sx = clampi(first_x + i , 0 , in_w - 1);
+                        sum += weights_y[j] * weights_x[i] * in[((size_t)sy * in_w + sx) * channels + c];
+                    }
+                }
+                out[((size_t)y * out_w + x) * channels + c] = to_byte((float)sum);
+            }
+        }
+    }
+
+    free(weights_x);
+    free(weights_y);
+}
+
+static int max_difference(const unsigned char *a , const unsigned char *b , size_t n)
+{
+    int worst = 0;
+    for(size_t i = 0 ; i < n ; i++)
+    {
+        int diff = abs((int)a[i] - (int)b[i]);
+        worst = diff > worst ? diff : worst;
+    }
+    return worst;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef enum
+{
+    OP_PYR_DOWN,
+    OP_PYR_UP,
+    OP_BILINEAR,
+    OP_AREA
+} resample_op;
+
+static const char *op_names[] = {"pyr_down" , "pyr_up" , "bilinear" , "area"};
+
+static int check_op(kernel_cache *cache , cl_command_queue queue , cl_context context , cl_device_id device , resample_path path ,
+                    int channels , resample_op op , int out_w , int out_h)
+{
+    size_t in_bytes = (size_t)CHECK_WIDTH * CHECK_HEIGHT * channels;
+    size_t out_bytes = (size_t)out_w * out_h * channels;
+    unsigned char *pixels = (unsigned char*)malloc(in_bytes);
+    unsigned char *expected = (unsigned char*)malloc(out_bytes);
+    unsigned char *result = (unsigned char*)malloc(out_bytes);
+    resample_frame in , out;
+    cl_int err;
+
+    make_image(pixels , CHECK_WIDTH , CHECK_HEIGHT , channels);
+    switch(op)
+    {
+        case OP_PYR_DOWN: reference_pyr_down(pixels , expected , CHECK_WIDTH , CHECK_HEIGHT , channels); break;
+        case OP_PYR_UP: reference_pyr_up(pixels , expected , CHECK_WIDTH , CHECK_HEIGHT , out_w , out_h , channels); break;
+        case OP_BILINEAR: reference_bilinear(pixels , expected , CHECK_WIDTH , CHECK_HEIGHT , out_w , out_h , channels); break;
+        case OP_AREA: reference_area(pixels , expected , CHECK_WIDTH , CHECK_HEIGHT , out_w , out_h , channels); break;
+    }
+
+    err = resample_frame_create(&in , context , device , CHECK_WIDTH , CHECK_HEIGHT , channels , path);
+    if(err == CL_SUCCESS)
+    {
+        err = resample_frame_create(&out , context , device , out_w , out_h , channels , path);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the check frames");
+        exit(1);
+    }
+
+    err = resample_frame_write(queue , &in , pixels);
+    if(err == CL_SUCCESS)
+    {
+        switch(op)
+        {
+            case OP_PYR_DOWN: err = launch_pyr_down(cache , queue , &in , &out , NULL); break;
+            case OP_PYR_UP: err = launch_pyr_up(cache , queue , &in , &out , NULL); break;
+            case OP_BILINEAR: err = launch_resize(cache , queue , &in , &out , RESIZE_BILINEAR , NULL); break;
+            case OP_AREA: err = launch_resize(cache , queue , &in , &out , RESIZE_AREA , NULL); break;
+        }
+    }
+    if(err == CL_SUCCESS)
+    {
+        err = resample_frame_read(queue , &out , result);
+    }
+
+    int tolerance = path == RESAMPLE_IMAGE ? 2 : 1;
+    int diff = err == CL_SUCCESS ? max_difference(expected , result , out_bytes) : -1;
+    int failed = diff < 0 || diff > tolerance;
+    if(failed)
+    {
+        printf("FAIL %s %d channel(s) %-8s %dx%d -> %dx%d: %s %d\n", path == RESAMPLE_IMAGE ? "image " : "buffer" , channels ,
+               op_names[op] , CHECK_WIDTH , CHECK_HEIGHT , out_w , out_h , diff < 0 ? "error" : "max difference" , diff < 0 ? err : diff);
+    }
+
+    resample_frame_release(&in);
+    resample_frame_release(&out);
+    free(pixels);
+    free(expected);
+    free(result);
+    return failed;
+}
+
+static int check_ops(kernel_cache *cache , cl_command_queue queue , cl_context context , cl_device_id device , resample_path path ,
+                     int channels)
+{
+    int failures = 0;
+
+    failures += check_op(cache , queue , context , device , path , channels , OP_PYR_DOWN , (CHECK_WIDTH + 1) / 2 , (CHECK_HEIGHT + 1) / 2);
+    failures += check_op(cache , queue , context , device , path , channels , OP_PYR_UP , 2 * CHECK_WIDTH , 2 * CHECK_HEIGHT);
+    failures += check_op(cache , queue , context , device , path , channels , OP_PYR_UP , 2 * CHECK_WIDTH - 1 , 2 * CHECK_HEIGHT - 1);
+    failures += check_op(cache , queue , context , device , path , channels , OP_BILINEAR , 300 , 50);
+    failures += check_op(cache , queue , context , device , path , channels , OP_BILINEAR , 61 , 203);
+    failures += check_op(cache , queue , context , device , path , channels , OP_AREA , 50 , 31);
+    failures += check_op(cache , queue , context , device , path , channels , OP_AREA , 100 , 40);
+    // Mixed: one axis shrinks while the other grows
+    failures += check_op(cache , queue , context , device , path , channels , OP_AREA , 300 , 50);
+    failures += check_op(cache , queue , context , device , path , channels , OP_AREA , 61 , 203);
+    return failures;
+}
+
+// Every level against a reduce of the level above it as the device computed it
+static int check_pyramid(kernel_cache *cache , cl_command_queue queue , cl_context context , cl_device_id device , resample_path path ,
+                         int width , int height , int channels)
+{
+    size_t bytes = (size_t)width * height * channels;
+    unsigned char *pixels = (unsigned char*)malloc(bytes);
+    unsigned char *above = (unsigned char*)malloc(bytes);
+    unsigned char *expected = (unsigned char*)malloc(bytes);
+    unsigned char *result = (unsigned char*)malloc(bytes);
+    resample_frame src;
+    pyramid pyr;
+    cl_int err;
+    int failures = 0;
+
+    make_image(pixels , width , height , channels);
+    err = resample_frame_create(&src , context , device , width , height , channels , RESAMPLE_BUFFER);
+    if(err == CL_SUCCESS)
+    {
+        err = pyramid_create(&pyr , context , device , width , height , channels , 0 , path);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the pyramid");
+        exit(1);
+    }
+
+    err = resample_frame_write(queue , &src , pixels);
+    if(err == CL_SUCCESS)
+    {
+        err = launch_pyramid(cache , queue , &pyr , &src , NULL);
+    }
+    if(err == CL_SUCCESS)
+    {
+        err = pyramid_read_level(queue , &pyr , 0 , above);
+    }
+    if(err != CL_SUCCESS || max_difference(pixels , above , bytes) != 0)
+    {
+        printf("FAIL %s pyramid %dx%d: level 0 (error %d)\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , width , height , err);
+        failures++;
+    }
+
+    int tolerance = path == RESAMPLE_IMAGE ? 2 : 1;
+    for(int level = 1 ; level < pyr.num_levels && err == CL_SUCCESS ; level++)
+    {
+        size_t level_bytes = (size_t)pyr.width[level] * pyr.height[level] * channels;
+        reference_pyr_down(above , expected , pyr.width[level - 1] , pyr.height[level - 1] , channels);
+        err = pyramid_read_level(queue , &pyr , level , result);
+
+        int diff = err == CL_SUCCESS ? max_difference(expected , result , level_bytes) : -1;
+        if(diff < 0 || diff > tolerance)
+        {
+            printf("FAIL %s pyramid %dx%d level %d (%dx%d): %s %d\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , width , height ,
+                   level , pyr.width[level] , pyr.height[level] , diff < 0 ? "error" : "max difference" , diff < 0 ? err : diff);
+            failures++;
+        }
+        memcpy(above , result , level_bytes);
+    }
+
+    if(pyr.width[pyr.num_levels - 1] != 1 || pyr.height[pyr.num_levels - 1] != 1)
+    {
+        printf("FAIL %s pyramid %dx%d: last level is %dx%d\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , width , height ,
+               pyr.width[pyr.num_levels - 1] , pyr.height[pyr.num_levels - 1]);
+        failures++;
+    }
+
+    pyramid_release(&pyr);
+    resample_frame_release(&src);
+    free(pixels);
+    free(above);
+    free(expected);
+    free(result);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// launch_pyramid against one launch_pyr_down per level into separate frames
+static void time_pyramid(kernel_cache *cache , cl_command_queue queue , cl_context context , cl_device_id device , resample_path path ,
+                         const unsigned char *pixels)
+{
+    resample_frame src , levels[PYRAMID_MAX_LEVELS];
+    pyramid pyr;
+    cl_event event;
+    cl_int err;
+
+    err = resample_frame_create(&src , context , device , FRAME_WIDTH , FRAME_HEIGHT , 1 , path);
+    if(err == CL_SUCCESS)
+    {
+        err = pyramid_create(&pyr , context , device , FRAME_WIDTH , FRAME_HEIGHT , 1 , 0 , path);
+    }
+    for(int level = 0 ; level < pyr.num_levels && err == CL_SUCCESS ; level++)
+    {
+        err = resample_frame_create(&levels[level] , context , device , pyr.width[level] , pyr.height[level] , 1 , path);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the pyramid frames");
+        exit(1);
+    }
+    resample_frame_write(queue , &src , pixels);
+    resample_frame_write(queue , &levels[0] , pixels);
+
+    // Warm-up launches build the variants
+    launch_pyramid(cache , queue , &pyr , &src , NULL);
+    launch_pyr_down(cache , queue , &levels[0] , &levels[1] , NULL);
+    clFinish(queue);
+
+    double start = bench_now_ms();
+    double pyramid_kernel_ms = 0.0;
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        launch_pyramid(cache , queue , &pyr , &src , &event);
+        clFinish(queue);
+        pyramid_kernel_ms += bench_event_ms(event);
+    }
+    double pyramid_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    start = bench_now_ms();
+    double level_kernel_ms = 0.0;
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        for(int level = 1 ; level < pyr.num_levels ; level++)
+        {
+            launch_pyr_down(cache , queue , &levels[level - 1] , &levels[level] , &event);
+            level_kernel_ms += bench_event_ms(event);
+        }
+        clFinish(queue);
+    }
+    double per_level_ms = (bench_now_ms() - start) / NUM_ITERATIONS;
+
+    // The pyramid event only covers its last launch , so its kernel column is that launch alone
+    printf("%-7s %-26s %12.3f %12.3f\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , "launch_pyramid" ,
+           pyramid_kernel_ms / NUM_ITERATIONS , pyramid_ms);
+    printf("%-7s %-26s %12.3f %12.3f\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , "launch_pyr_down per level" ,
+           level_kernel_ms / NUM_ITERATIONS , per_level_ms);
+
+    for(int level = 0 ; level < pyr.num_levels ; level++)
+    {
+        resample_frame_release(&levels[level]);
+    }
+    pyramid_release(&pyr);
+    resample_frame_release(&src);
+}
+
+static void time_resize(kernel_cache *cache , cl_command_queue queue , cl_context context , cl_device_id device , resample_path path ,
+                        int channels , const unsigned char *pixels , int out_w , int out_h , resize_method method)
+{
+    resample_frame in , out;
+    cl_event event;
+    cl_int err;
+
+    err = resample_frame_create(&in , context , device , FRAME_WIDTH , FRAME_HEIGHT , channels , path);
+    if(err == CL_SUCCESS)
+    {
+        err = resample_frame_create(&out , context , device , out_w , out_h , channels , path);
+    }
+    if(err < 0)
+    {
+        perror("Couldn't create the resize frames");
+        exit(1);
+    }
+    resample_frame_write(queue , &in , pixels);
+
+    launch_resize(cache , queue , &in , &out , method , NULL);
+    clFinish(queue);
+
+    double kernel_ms = 0.0;
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        launch_resize(cache , queue , &in , &out , method , &event);
+        kernel_ms += bench_event_ms(event);
+    }
+
+    printf("%-7s %d channel(s) %-8s -> %4dx%-4d %12.3f\n", path == RESAMPLE_IMAGE ? "image" : "buffer" , channels ,
+           method == RESIZE_AREA ? "area" : "bilinear" , out_w , out_h , kernel_ms / NUM_ITERATIONS);
+
+    resample_frame_release(&in);
+    resample_frame_release(&out);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    int failures = 0;
+
+    bench_init(&bench , 1);
+
+    int images = resample_image_supported(bench.context , bench.device , 1) && resample_image_supported(bench.context , bench.device , 4);
+    printf("Image path: %s\n", images ? "available" : "not supported , buffers only");
+
+    // Correctness
+    for(int channels = 1 ; channels <= 4 ; channels++)
+    {
+        if(channels == 2)
+        {
+            continue;
+        }
+        failures += check_ops(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_BUFFER , channels);
+        if(images && channels != 3)
+        {
+            failures += check_ops(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_IMAGE , channels);
+        }
+    }
+    failures += check_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_BUFFER , 640 , 480 , 1);
+    failures += check_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_BUFFER , 333 , 201 , 3);
+    if(images)
+    {
+        failures += check_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_IMAGE , 640 , 480 , 1);
+        failures += check_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_IMAGE , 333 , 201 , 4);
+    }
+
+    // Speed
+    unsigned char *pixels = (unsigned char*)malloc((size_t)FRAME_WIDTH * FRAME_HEIGHT * 4);
+    make_image(pixels , FRAME_WIDTH , FRAME_HEIGHT , 1);
+
+    printf("\n%dx%d gray pyramid down to 1x1 , ms\n", FRAME_WIDTH , FRAME_HEIGHT);
+    printf("%-7s %-26s %12s %12s\n", "path" , "method" , "kernel" , "end to end");
+    time_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_BUFFER , pixels);
+    if(images)
+    {
+        time_pyramid(&bench.cache , bench.queue , bench.context , bench.device , RESAMPLE_IMAGE , pixels);
+    }
+
+    printf("\n%dx%d resize , kernel ms\n", FRAME_WIDTH , FRAME_HEIGHT);
+    for(int path = RESAMPLE_BUFFER ; path <= RESAMPLE_IMAGE ; path++)
+    {
+        if(path == RESAMPLE_IMAGE && !images)
+        {
+            break;
+        }
+        for(int channels = 1 ; channels <= 4 ; channels += 3)
+        {
+            make_image(pixels , FRAME_WIDTH , FRAME_HEIGHT , channels);
+            time_resize(&bench.cache , bench.queue , bench.context , bench.device , (resample_path)path , channels , pixels ,
+                        1280 , 720 , RESIZE_BILINEAR);
+            time_resize(&bench.cache , bench.queue , bench.context , bench.device , (resample_path)path , channels , pixels ,
+                        480 , 270 , RESIZE_BILINEAR);
+            time_resize(&bench.cache , bench.queue , bench.context , bench.device , (resample_path)path , channels , pixels ,
+                        480 , 270 , RESIZE_AREA);
+        }
+    }
+
+    printf("\n%d check(s) failed.\n", failures);
+
+    free(pixels);
+    bench_release(&bench);
+
+    return failures;
+}
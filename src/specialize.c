@@ -0,0 +1,104 @@
+#include <stdio.h>
+
+#include "specialize.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static cl_kernel blur_variant(kernel_cache *cache , const char *kernel_name , int radius , kernel_variant variant)
+{
+    char options[64] = "";
+
+    if(variant == VARIANT_AUTO)
+    {
+        variant = (radius <= MAX_SPECIALIZED_RADIUS) ? VARIANT_SPECIALIZED : VARIANT_GENERIC;
+    }
+
+    if(variant == VARIANT_SPECIALIZED)
+    {
+        snprintf(options , sizeof(options) , "-DBLUR_SIZE=%d", radius);
+    }
+
+    return kernel_cache_get(cache , SPECIALIZE_PROGRAM , kernel_name , options);
+}
+
+cl_kernel blur_kernel(kernel_cache *cache , int radius , kernel_variant variant)
+{
+    return blur_variant(cache , "blurKernel" , radius , variant);
+}
+
+cl_int enqueue_blur(cl_command_queue queue , cl_kernel kernel , cl_mem in , cl_mem out , int width , int height , int radius ,
+                    cl_event *event)
+{
+    cl_int err;
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &in);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &out);
+    err |= clSetKernelArg(kernel , 2 , sizeof(int) , &width);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &height);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &radius);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {16 , 16};
+    size_t global_size[2] = {(width + 15) / 16 * 16 , (height + 15) / 16 * 16};
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
+
+cl_int launch_blur(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out ,
+                   int width , int height , int radius , kernel_variant variant , cl_event *event)
+{
+    return enqueue_blur(queue , blur_kernel(cache , radius , variant) , in , out , width , height , radius , event);
+}
+
+cl_int launch_blur_planar(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out ,
+                          int width , int height , int radius , kernel_variant variant , cl_event *event)
+{
+    cl_kernel kernel = blur_variant(cache , "blurPlanarKernel" , radius , variant);
+    return enqueue_blur(queue , kernel , in , out , width , height , radius , event);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int launch_matmul(kernel_cache *cache , cl_command_queue queue , cl_mem pIn1 , cl_mem pIn2 , cl_mem pOut ,
+                     int m , int n , int k , const char *type_name , kernel_variant variant , cl_event *event)
+{
+    char options[128];
+    cl_kernel kernel;
+    cl_int err;
+
+    if(variant == VARIANT_AUTO)
+    {
+        variant = (k <= MAX_SPECIALIZED_K) ? VARIANT_SPECIALIZED : VARIANT_GENERIC;
+    }
+
+    if(variant == VARIANT_SPECIALIZED)
+    {
+        int exact = (m % MATMUL_TILE == 0) && (n % MATMUL_TILE == 0) && (k % MATMUL_TILE == 0);
+        snprintf(options , sizeof(options) , "-DT=%s -DTILE=%d -DK_DIM=%d%s",
+                 type_name , MATMUL_TILE , k , exact ? " -DEXACT_TILES" : "");
+    }
+    else
+    {
+        snprintf(options , sizeof(options) , "-DT=%s -DTILE=%d", type_name , MATMUL_TILE);
+    }
+
+    kernel = kernel_cache_get(cache , SPECIALIZE_PROGRAM , "matrixMultiplicationKernel" , options);
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &pIn1);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &pIn2);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &pOut);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &m);
+    err |= clSetKernelArg(kernel , 4 , sizeof(int) , &n);
+    err |= clSetKernelArg(kernel , 5 , sizeof(int) , &k);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t local_size[2] = {MATMUL_TILE , MATMUL_TILE};
+    size_t global_size[2] = {(n + MATMUL_TILE - 1) / MATMUL_TILE * MATMUL_TILE ,
+                             (m + MATMUL_TILE - 1) / MATMUL_TILE * MATMUL_TILE};
+
+    return clEnqueueNDRangeKernel(queue , kernel , 2 , NULL , global_size , local_size , 0 , NULL , event);
+}
@@ -0,0 +1,194 @@
+/*
+    Templated kernels. Every macro below can be supplied as a -D build option, and each distinct set of options is a separate kernel variant.
+
+    T           element type of the matrix multiplication (default float)
+    TILE        edge of the square local memory tile used by the matrix multiplication (default 16)
+    K_DIM       columns of pIn1 / rows of pIn2. When undefined the runtime argument k is used.
+    EXACT_TILES m , n and k are multiples of TILE, so the bounds checks are dropped.
+    BLUR_SIZE   blur radius. When undefined the runtime argument radius is used.
+
+    With a compile time trip count the compiler can fully unroll the loops, and the division by the pixel count becomes a multiplication.
+*/
+
+#ifndef T
+#define T float
+#endif
+
+#ifndef TILE
+#define TILE 16
+#endif
+
+#ifdef K_DIM
+#define KDIM K_DIM
+#else
+#define KDIM k
+#endif
+
+#ifdef BLUR_SIZE
+#define RADIUS BLUR_SIZE
+#else
+#define RADIUS radius
+#endif
+
+__kernel void blurKernel(__global const uchar *pIn , __global uchar *pOut , int width , int height , int radius)
+{
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    int pixValr = 0;
+    int pixValg = 0;
+    int pixValb = 0;
+    int pixels = 0;
+
+    if(row >= RADIUS && row < height - RADIUS && col >= RADIUS && col < width - RADIUS)
+    {
+        // Interior pixel: the whole window is inside the image, so no per tap bounds checks
+        for(int blurRow = -RADIUS ; blurRow < RADIUS + 1 ; ++blurRow)
+        {
+            int rgbOffset = ((row + blurRow) * width + col - RADIUS) * 3;
+            for(int blurCol = 0 ; blurCol < 2 * RADIUS + 1 ; ++blurCol)
+            {
+                pixValr += pIn[rgbOffset + blurCol * 3];
+                pixValg += pIn[rgbOffset + blurCol * 3 + 1];
+                pixValb += pIn[rgbOffset + blurCol * 3 + 2];
+            }
+        }
+        pixels = (2 * RADIUS + 1) * (2 * RADIUS + 1);
+    }
+    else
+    {
+        for(int blurRow = -RADIUS ; blurRow < RADIUS + 1 ; ++blurRow)
+        {
+            for(int blurCol = -RADIUS ; blurCol < RADIUS + 1 ; ++blurCol)
+            {
+                int currRow = row + blurRow;
+                int currCol = col + blurCol;
+
+                if(currRow >= 0 && currRow < height && currCol >= 0 && currCol < width)
+                {
+                    int rgbOffset = (currRow * width + currCol) * 3;
+                    pixValr += pIn[rgbOffset];
+                    pixValg += pIn[rgbOffset + 1];
+                    pixValb += pIn[rgbOffset + 2];
+                    ++pixels;
+                }
+            }
+        }
+    }
+
+    int rgbOffset = (row * width + col) * 3;
+    pOut[rgbOffset] = pixValr / pixels;
+    pOut[rgbOffset + 1] = pixValg / pixels;
+    pOut[rgbOffset + 2] = pixValb / pixels;
+}
+
+/*
+    Same blur on planar RGB (three planes of width x height , see launch_to_planar in layout.h).
+    Neighbouring work-items read neighbouring bytes of each plane instead of bytes 3 apart.
+*/
+__kernel void blurPlanarKernel(__global const uchar *pIn , __global uchar *pOut , int width , int height , int radius)
+{
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+
+    if(col >= width || row >= height)
+    {
+        return;
+    }
+
+    int plane = width * height;
+    int pixValr = 0;
+    int pixValg = 0;
+    int pixValb = 0;
+    int pixels = 0;
+
+    if(row >= RADIUS && row < height - RADIUS && col >= RADIUS && col < width - RADIUS)
+    {
+        for(int blurRow = -RADIUS ; blurRow < RADIUS + 1 ; ++blurRow)
+        {
+            int offset = (row + blurRow) * width + col - RADIUS;
+            for(int blurCol = 0 ; blurCol < 2 * RADIUS + 1 ; ++blurCol)
+            {
+                pixValr += pIn[offset + blurCol];
+                pixValg += pIn[plane + offset + blurCol];
+                pixValb += pIn[2 * plane + offset + blurCol];
+            }
+        }
+        pixels = (2 * RADIUS + 1) * (2 * RADIUS + 1);
+    }
+    else
+    {
+        for(int blurRow = -RADIUS ; blurRow < RADIUS + 1 ; ++blurRow)
+        {
+            for(int blurCol = -RADIUS ; blurCol < RADIUS + 1 ; ++blurCol)
+            {
+                int currRow = row + blurRow;
+                int currCol = col + blurCol;
+
+                if(currRow >= 0 && currRow < height && currCol >= 0 && currCol < width)
+                {
+                    int offset = currRow * width + currCol;
+                    pixValr += pIn[offset];
+                    pixValg += pIn[plane + offset];
+                    pixValb += pIn[2 * plane + offset];
+                    ++pixels;
+                }
+            }
+        }
+    }
+
+    int offset = row * width + col;
+    pOut[offset] = pixValr / pixels;
+    pOut[plane + offset] = pixValg / pixels;
+    pOut[2 * plane + offset] = pixValb / pixels;
+}
+
+/*
+    m : rows in pIn1
+    n : columns in pIn2
+    k : columns in pIn1 and rows in pIn2
+
+    Launched with a TILE x TILE work-group. The global size is rounded up to a multiple of TILE.
+*/
+__kernel void matrixMultiplicationKernel(__global const T *pIn1 , __global const T *pIn2 , __global T *pOut , int m , int n , int k)
+{
+    __local T tileA[TILE][TILE];
+    __local T tileB[TILE][TILE];
+
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    int localCol = get_local_id(0);
+    int localRow = get_local_id(1);
+
+    T sum = 0;
+
+    for(int t = 0 ; t < KDIM ; t += TILE)
+    {
+#ifdef EXACT_TILES
+        tileA[localRow][localCol] = pIn1[row * KDIM + t + localCol];
+        tileB[localRow][localCol] = pIn2[(t + localRow) * n + col];
+#else
+        tileA[localRow][localCol] = (row < m && t + localCol < KDIM) ? pIn1[row * KDIM + t + localCol] : 0;
+        tileB[localRow][localCol] = (col < n && t + localRow < KDIM) ? pIn2[(t + localRow) * n + col] : 0;
+#endif
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for(int index = 0 ; index < TILE ; index++)
+        {
+            sum += tileA[localRow][index] * tileB[index][localCol];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+#ifndef EXACT_TILES
+    if(row < m && col < n)
+#endif
+    {
+        pOut[row * n + col] = sum;
+    }
+}
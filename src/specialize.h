@@ -0,0 +1,52 @@
+/*
+
+Specialized Kernel Launchers
+----------------------------
+
+1. The launchers below pick a variant of the kernels in specialize.cl and enqueue it.
+2. VARIANT_GENERIC builds the kernel without size constants, so the sizes are passed as runtime arguments.
+3. VARIANT_SPECIALIZED bakes the sizes into the kernel with -D options (BLUR_SIZE , K_DIM , TILE , T , EXACT_TILES).
+4. VARIANT_AUTO uses the specialized kernel whenever the sizes are small enough that the number of variants stays bounded,
+   and falls back to the generic kernel otherwise.
+5. launch_blur is blur_kernel followed by enqueue_blur. Calling them separately keeps the first build of a variant out of
+   whatever the caller times around the enqueue.
+
+*/
+
+#ifndef SPECIALIZE_H
+#define SPECIALIZE_H
+
+#include "kernel_cache.h"
+
+#define SPECIALIZE_PROGRAM "specialize.cl"
+#define MAX_SPECIALIZED_RADIUS 8
+#define MAX_SPECIALIZED_K 4096
+#define MATMUL_TILE 16
+
+typedef enum
+{
+    VARIANT_AUTO,
+    VARIANT_GENERIC,
+    VARIANT_SPECIALIZED
+} kernel_variant;
+
+// The blurKernel variant launch_blur would use for radius , fetched (and built on the first request) from the cache
+cl_kernel blur_kernel(kernel_cache *cache , int radius , kernel_variant variant);
+
+// Sets the arguments of a blur kernel (interleaved or planar) and enqueues it. radius must match the variant.
+cl_int enqueue_blur(cl_command_queue queue , cl_kernel kernel , cl_mem in , cl_mem out , int width , int height , int radius ,
+                    cl_event *event);
+
+// Box blur of an interleaved 8-bit RGB image of width x height pixels
+cl_int launch_blur(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out ,
+                   int width , int height , int radius , kernel_variant variant , cl_event *event);
+
+// Same blur of a planar RGB image (three planes of width x height bytes)
+cl_int launch_blur_planar(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out ,
+                          int width , int height , int radius , kernel_variant variant , cl_event *event);
+
+// pOut (m x n) = pIn1 (m x k) * pIn2 (k x n). type_name is the OpenCL element type, e.g. "float" or "uint".
+cl_int launch_matmul(kernel_cache *cache , cl_command_queue queue , cl_mem pIn1 , cl_mem pIn2 , cl_mem pOut ,
+                     int m , int n , int k , const char *type_name , kernel_variant variant , cl_event *event);
+
+#endif
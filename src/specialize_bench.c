@@ -0,0 +1,235 @@
+/*
+
+Specialized vs Generic Kernels
+------------------------------
+
+1. Times the generic (runtime sizes) and specialized (-D sizes) variants of blurKernel and matrixMultiplicationKernel from specialize.cl.
+2. Kernel times come from event profiling (CL_PROFILING_COMMAND_START / CL_PROFILING_COMMAND_END), so host overhead is not included.
+3. The first launch of every variant builds the program. The build is excluded by running one warm-up launch per variant.
+4. Both blur variants must produce identical results. Both matrix products are checked against the blocked host reference of
+   verify_matmul with ulp / relative tolerances: the specialized variant may contract to FMAs , so bit equality is not expected.
+5. verify_matmul itself is checked on the verified product: once with a sample_threshold below m * n so only a random sample is
+   compared , and once per path with one corrupted element , which must fail and be reported as the worst index.
+6. The exit code is the number of failed checks.
+
+Build:
+    gcc specialize_bench.c specialize.c bench_common.c kernel_cache.c verify.c thread_pool.c -o specialize_bench -lOpenCL -lpthread -lm
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "specialize.h"
+#include "verify.h"
+
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+#define MAT_SIZE 512
+#define NUM_ITERATIONS 10
+#define NUM_SAMPLES 1000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double time_blur(kernel_cache *cache , cl_command_queue queue , cl_mem in , cl_mem out , int radius , kernel_variant variant)
+{
+    cl_event event;
+    double total = 0.0;
+
+    // Warm-up launch builds the variant
+    launch_blur(cache , queue , in , out , IMAGE_WIDTH , IMAGE_HEIGHT , radius , variant , NULL);
+    clFinish(queue);
+
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        if(launch_blur(cache , queue , in , out , IMAGE_WIDTH , IMAGE_HEIGHT , radius , variant , &event) != CL_SUCCESS)
+        {
+            printf("Couldn't enqueue blurKernel\n");
+            exit(1);
+        }
+        total += bench_event_ms(event);
+    }
+
+    return total / NUM_ITERATIONS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double time_matmul(kernel_cache *cache , cl_command_queue queue , cl_mem a , cl_mem b , cl_mem c , kernel_variant variant)
+{
+    cl_event event;
+    double total = 0.0;
+
+    launch_matmul(cache , queue , a , b , c , MAT_SIZE , MAT_SIZE , MAT_SIZE , "float" , variant , NULL);
+    clFinish(queue);
+
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        if(launch_matmul(cache , queue , a , b , c , MAT_SIZE , MAT_SIZE , MAT_SIZE , "float" , variant , &event) != CL_SUCCESS)
+        {
+            printf("Couldn't enqueue matrixMultiplicationKernel\n");
+            exit(1);
+        }
+        total += bench_event_ms(event);
+    }
+
+    return total / NUM_ITERATIONS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int check_matmul(thread_pool *pool , const char *name , const float *a , const float *b , const float *c ,
+                        verify_tolerance tolerance , size_t expected_checked , size_t bad_index)
+{
+    verify_report report;
+    int passed = verify_matmul(pool , a , b , c , MAT_SIZE , MAT_SIZE , MAT_SIZE , tolerance , &report);
+    int ok;
+
+    if(bad_index == (size_t)-1)
+    {
+        ok = passed && report.checked == expected_checked;
+    }
+    else
+    {
+        ok = !passed && report.worst_index == bad_index;
+    }
+
+    printf("%-34s %s\n", name , ok ? "PASS" : "FAIL");
+    if(!ok)
+    {
+        verify_print(name , &report);
+    }
+    return !ok;
+}
+
+// c is a product that already passed the full check with tolerance
+static int check_verifier(thread_pool *pool , const float *a , const float *b , const float *c , verify_tolerance tolerance)
+{
+    size_t total = (size_t)MAT_SIZE * MAT_SIZE;
+    verify_tolerance full = tolerance;
+    verify_tolerance sampled = tolerance;
+    float *corrupt = (float*)malloc(sizeof(float) * total);
+    int failures = 0;
+
+    sampled.sample_threshold = total / 4;
+    sampled.num_samples = NUM_SAMPLES;
+
+    failures += check_matmul(pool , "verify_matmul sampled" , a , b , c , sampled , NUM_SAMPLES , (size_t)-1);
+
+    // The sample always holds the first and last element , so the last one is certain to be seen
+    memcpy(corrupt , c , sizeof(float) * total);
+    corrupt[total / 3 + 7] += 1.0f;
+    failures += check_matmul(pool , "verify_matmul full , corrupted" , a , b , corrupt , full , total , total / 3 + 7);
+
+    memcpy(corrupt , c , sizeof(float) * total);
+    corrupt[total - 1] += 1.0f;
+    failures += check_matmul(pool , "verify_matmul sampled , corrupted" , a , b , corrupt , sampled , NUM_SAMPLES , total - 1);
+
+    free(corrupt);
+    return failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    int failures = 0;
+
+    bench_init(&bench , 1);
+
+    // Blur: random RGB image
+    size_t image_bytes = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT * 3;
+    unsigned char *image = (unsigned char*)malloc(image_bytes);
+    unsigned char *generic_out = (unsigned char*)malloc(image_bytes);
+    unsigned char *special_out = (unsigned char*)malloc(image_bytes);
+    for(size_t i = 0 ; i < image_bytes ; i++)
+    {
+        image[i] = (unsigned char)(rand() & 0xFF);
+    }
+
+    cl_mem image_in = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , image_bytes , image , &err);
+    cl_mem image_out = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , image_bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the image buffers");
+        exit(1);
+    }
+
+    printf("blurKernel %dx%d\n", IMAGE_WIDTH , IMAGE_HEIGHT);
+    printf("%8s %14s %14s %9s\n", "radius" , "generic (ms)" , "special (ms)" , "speedup");
+    for(int radius = 1 ; radius <= MAX_SPECIALIZED_RADIUS ; radius *= 2)
+    {
+        double generic_ms = time_blur(&bench.cache , bench.queue , image_in , image_out , radius , VARIANT_GENERIC);
+        clEnqueueReadBuffer(bench.queue , image_out , CL_TRUE , 0 , image_bytes , generic_out , 0 , NULL , NULL);
+
+        double special_ms = time_blur(&bench.cache , bench.queue , image_in , image_out , radius , VARIANT_SPECIALIZED);
+        clEnqueueReadBuffer(bench.queue , image_out , CL_TRUE , 0 , image_bytes , special_out , 0 , NULL , NULL);
+
+        int same = memcmp(generic_out , special_out , image_bytes) == 0;
+        printf("%8d %14.3f %14.3f %8.2fx %s\n", radius , generic_ms , special_ms , generic_ms / special_ms , same ? "" : "MISMATCH");
+        failures += !same;
+    }
+
+    // Matrix multiplication: random float matrices , so the sums are not exact and the tolerances matter
+    thread_pool *pool = thread_pool_create(0);
+    size_t mat_bytes = (size_t)MAT_SIZE * MAT_SIZE * sizeof(float);
+    float *a = (float*)malloc(mat_bytes);
+    float *b = (float*)malloc(mat_bytes);
+    float *generic_c = (float*)malloc(mat_bytes);
+    float *special_c = (float*)malloc(mat_bytes);
+    for(int i = 0 ; i < MAT_SIZE * MAT_SIZE ; i++)
+    {
+        a[i] = (float)rand() / RAND_MAX - 0.5f;
+        b[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+
+    cl_mem a_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , mat_bytes , a , &err);
+    cl_mem b_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , mat_bytes , b , &err);
+    cl_mem c_buff = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , mat_bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the matrix buffers");
+        exit(1);
+    }
+
+    double generic_ms = time_matmul(&bench.cache , bench.queue , a_buff , b_buff , c_buff , VARIANT_GENERIC);
+    clEnqueueReadBuffer(bench.queue , c_buff , CL_TRUE , 0 , mat_bytes , generic_c , 0 , NULL , NULL);
+
+    double special_ms = time_matmul(&bench.cache , bench.queue , a_buff , b_buff , c_buff , VARIANT_SPECIALIZED);
+    clEnqueueReadBuffer(bench.queue , c_buff , CL_TRUE , 0 , mat_bytes , special_c , 0 , NULL , NULL);
+
+    printf("\nmatrixMultiplicationKernel %dx%dx%d\n", MAT_SIZE , MAT_SIZE , MAT_SIZE);
+    printf("%14s %14s %9s\n", "generic (ms)" , "special (ms)" , "speedup");
+    printf("%14.3f %14.3f %8.2fx\n\n", generic_ms , special_ms , generic_ms / special_ms);
+
+    // A float sum of MAT_SIZE products of size 0.25 carries an absolute error of a few 1e-6 , and elements that cancel to
+    // near zero have no meaningful relative error , hence the absolute tolerance
+    verify_tolerance tolerance = VERIFY_DEFAULT_TOLERANCE;
+    tolerance.abs_tol = 1e-4f;
+    tolerance.rel_tol = 1e-4f;
+
+    size_t total = (size_t)MAT_SIZE * MAT_SIZE;
+    failures += check_matmul(pool , "matmul generic" , a , b , generic_c , tolerance , total , (size_t)-1);
+    failures += check_matmul(pool , "matmul specialized" , a , b , special_c , tolerance , total , (size_t)-1);
+    failures += check_verifier(pool , a , b , generic_c , tolerance);
+
+    printf("\nKernel cache: %zu variants , %zu hits , %zu misses\n", bench.cache.num_entries , bench.cache.hits , bench.cache.misses);
+    printf("%d check(s) failed.\n", failures);
+
+    free(image);
+    free(generic_out);
+    free(special_out);
+    free(a);
+    free(b);
+    free(generic_c);
+    free(special_c);
+    clReleaseMemObject(image_in);
+    clReleaseMemObject(image_out);
+    clReleaseMemObject(a_buff);
+    clReleaseMemObject(b_buff);
+    clReleaseMemObject(c_buff);
+    thread_pool_destroy(pool);
+    bench_release(&bench);
+
+    return failures;
+}
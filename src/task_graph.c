@@ -0,0 +1,385 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "task_graph.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int task_graph_init(task_graph *graph , cl_context context , cl_device_id device , cl_command_queue_properties extra_properties)
+{
+    cl_command_queue_properties supported = 0;
+    cl_int err;
+
+    memset(graph , 0 , sizeof(*graph));
+    graph->context = context;
+    graph->device = device;
+
+    clGetDeviceInfo(device , CL_DEVICE_QUEUE_ON_HOST_PROPERTIES , sizeof(supported) , &supported , NULL);
+    graph->out_of_order = (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+    graph->num_queues = graph->out_of_order ? 1 : TASK_GRAPH_NUM_QUEUES;
+
+    cl_queue_properties props[] = {CL_QUEUE_PROPERTIES ,
+                                   extra_properties | (graph->out_of_order ? CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE : 0) , 0};
+
+    for(int i = 0 ; i < graph->num_queues ; i++)
+    {
+        graph->queues[i] = clCreateCommandQueueWithProperties(context , device , props , &err);
+        if(err < 0)
+        {
+            for(int j = 0 ; j < i ; j++)
+            {
+                clReleaseCommandQueue(graph->queues[j]);
+            }
+            graph->num_queues = 0;
+            return err;
+        }
+    }
+
+    return CL_SUCCESS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int conflicts(const task_node *earlier , const task_node *later)
+{
+    for(int i = 0 ; i < earlier->num_uses ; i++)
+    {
+        for(int j = 0 ; j < later->num_uses ; j++)
+        {
+            if(earlier->uses[i].resource != later->uses[j].resource)
+            {
+                continue;
+            }
+            // Two reads of the same memory can overlap, any write orders them
+            if((earlier->uses[i].access & TASK_ACCESS_WRITE) || (later->uses[j].access & TASK_ACCESS_WRITE))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+    1. Dependencies only point to earlier nodes, so insertion order is already a topological order.
+    2. In-order queue mode: a node continues on the queue of its first dependency when no sibling has taken that queue yet,
+       so a chain stays on one queue and needs no cross-queue events. Other nodes are dealt round-robin.
+*/
+static int add_node(task_graph *graph , task_node *node)
+{
+    static const int unclaimed = -1;
+    int index = graph->num_nodes;
+
+    node->deps = (int*)malloc(sizeof(int) * (index ? index : 1));
+    node->num_deps = 0;
+    for(int i = 0 ; i < index ; i++)
+    {
+        if(conflicts(&graph->nodes[i] , node))
+        {
+            node->deps[node->num_deps++] = i;
+        }
+    }
+
+    node->queue_index = 0;
+    if(!graph->out_of_order)
+    {
+        node->queue_index = unclaimed;
+        for(int i = 0 ; i < node->num_deps && node->queue_index == unclaimed ; i++)
+        {
+            task_node *dep = &graph->nodes[node->deps[i]];
+            int taken = 0;
+            for(int j = node->deps[i] + 1 ; j < index && !taken ; j++)
+            {
+                taken = graph->nodes[j].queue_index == dep->queue_index;
+            }
+            if(!taken)
+            {
+                node->queue_index = dep->queue_index;
+            }
+        }
+        if(node->queue_index == unclaimed)
+        {
+            node->queue_index = index % graph->num_queues;
+        }
+    }
+
+    node->event = NULL;
+
+    if(graph->num_nodes == graph->capacity)
+    {
+        graph->capacity = graph->capacity ? graph->capacity * 2 : 16;
+        graph->nodes = (task_node*)realloc(graph->nodes , sizeof(task_node) * graph->capacity);
+    }
+    graph->nodes[graph->num_nodes++] = *node;
+
+    return index;
+}
+
+static task_use* make_uses(int count)
+{
+    return (task_use*)malloc(sizeof(task_use) * (count ? count : 1));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int task_graph_add_kernel(task_graph *graph , cl_kernel kernel , cl_uint work_dim , const size_t *global_size , const size_t *local_size ,
+                          cl_uint num_args , const task_arg *args)
+{
+    task_node node;
+
+    if(work_dim == 0 || work_dim > 3 || global_size == NULL || num_args > TASK_GRAPH_MAX_ARGS)
+    {
+        return -1;
+    }
+
+    // A buffer argument is read as a cl_mem to find its dependencies , so it must point at exactly one
+    for(cl_uint i = 0 ; i < num_args ; i++)
+    {
+        if(args[i].access != TASK_ACCESS_NONE && (args[i].value == NULL || args[i].size != sizeof(cl_mem)))
+        {
+            return -1;
+        }
+    }
+
+    memset(&node , 0 , sizeof(node));
+    node.type = TASK_NODE_KERNEL;
+    node.kernel = kernel;
+    node.work_dim = work_dim;
+    node.num_args = num_args;
+    node.has_local_size = local_size != NULL;
+
+    for(cl_uint d = 0 ; d < work_dim ; d++)
+    {
+        node.global_size[d] = global_size[d];
+        node.local_size[d] = local_size ? local_size[d] : 0;
+    }
+
+    node.uses = make_uses(node.num_args);
+    for(cl_uint i = 0 ; i < node.num_args ; i++)
+    {
+        node.arg_sizes[i] = args[i].size;
+        node.arg_access[i] = args[i].access;
+        node.arg_values[i] = NULL;
+        if(args[i].value != NULL)
+        {
+            node.arg_values[i] = (unsigned char*)malloc(args[i].size);
+            memcpy(node.arg_values[i] , args[i].value , args[i].size);
+        }
+        if(args[i].access != TASK_ACCESS_NONE)
+        {
+            node.uses[node.num_uses].resource = *(const cl_mem*)args[i].value;
+            node.uses[node.num_uses].access = args[i].access;
+            node.num_uses++;
+        }
+    }
+
+    return add_node(graph , &node);
+}
+
+int task_graph_add_write(task_graph *graph , cl_mem buffer , size_t offset , size_t size , const void *host_ptr)
+{
+    task_node node;
+
+    memset(&node , 0 , sizeof(node));
+    node.type = TASK_NODE_WRITE;
+    node.dst = buffer;
+    node.host_ptr = (void*)host_ptr;
+    node.dst_offset = offset;
+    node.size = size;
+    node.uses = make_uses(2);
+    node.uses[0] = (task_use){buffer , TASK_ACCESS_WRITE};
+    node.uses[1] = (task_use){host_ptr , TASK_ACCESS_READ};
+    node.num_uses = 2;
+
+    return add_node(graph , &node);
+}
+
+int task_graph_add_read(task_graph *graph , cl_mem buffer , size_t offset , size_t size , void *host_ptr)
+{
+    task_node node;
+
+    memset(&node , 0 , sizeof(node));
+    node.type = TASK_NODE_READ;
+    node.src = buffer;
+    node.host_ptr = host_ptr;
+    node.src_offset = offset;
+    node.size = size;
+    node.uses = make_uses(2);
+    node.uses[0] = (task_use){buffer , TASK_ACCESS_READ};
+    node.uses[1] = (task_use){host_ptr , TASK_ACCESS_WRITE};
+    node.num_uses = 2;
+
+    return add_node(graph , &node);
+}
+
+int task_graph_add_copy(task_graph *graph , cl_mem src , cl_mem dst , size_t src_offset , size_t dst_offset , size_t size)
+{
+    task_node node;
+
+    memset(&node , 0 , sizeof(node));
+    node.type = TASK_NODE_COPY;
+    node.src = src;
+    node.dst = dst;
+    node.src_offset = src_offset;
+    node.dst_offset = dst_offset;
+    node.size = size;
+    node.uses = make_uses(2);
+    node.uses[0] = (task_use){src , TASK_ACCESS_READ};
+    node.uses[1] = (task_use){dst , TASK_ACCESS_WRITE};
+    node.num_uses = 2;
+
+    return add_node(graph , &node);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_int task_graph_set_arg(task_graph *graph , int node , cl_uint arg_index , size_t size , const void *value)
+{
+    if(node < 0 || node >= graph->num_nodes || graph->nodes[node].type != TASK_NODE_KERNEL)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    task_node *n = &graph->nodes[node];
+    if(arg_index >= n->num_args)
+    {
+        return CL_INVALID_ARG_INDEX;
+    }
+    // The edges were built from this buffer: another one could race with the nodes it no longer orders
+    if(n->arg_access[arg_index] != TASK_ACCESS_NONE)
+    {
+        return CL_INVALID_ARG_VALUE;
+    }
+
+    free(n->arg_values[arg_index]);
+    n->arg_values[arg_index] = NULL;
+    n->arg_sizes[arg_index] = size;
+    if(value != NULL)
+    {
+        n->arg_values[arg_index] = (unsigned char*)malloc(size);
+        memcpy(n->arg_values[arg_index] , value , size);
+    }
+    return CL_SUCCESS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void release_events(task_graph *graph)
+{
+    for(int i = 0 ; i < graph->num_nodes ; i++)
+    {
+        if(graph->nodes[i].event != NULL)
+        {
+            clReleaseEvent(graph->nodes[i].event);
+            graph->nodes[i].event = NULL;
+        }
+    }
+}
+
+/*
+    1. Kernel arguments are applied right before each enqueue. clEnqueueNDRangeKernel captures the argument values,
+       so one cl_kernel can appear in several nodes with different arguments.
+    2. On an in-order queue, a dependency on the same queue is already ordered, so only cross-queue events go in the wait list.
+    3. A new run first waits for the previous one.
+*/
+cl_int task_graph_run(task_graph *graph)
+{
+    cl_event *wait_list = (cl_event*)malloc(sizeof(cl_event) * (graph->num_nodes ? graph->num_nodes : 1));
+    cl_int err = CL_SUCCESS;
+
+    // Runs are not overlapped: the hazards between the last nodes of one run and the first nodes of the next are not tracked
+    task_graph_wait(graph);
+    release_events(graph);
+
+    for(int i = 0 ; i < graph->num_nodes && err == CL_SUCCESS ; i++)
+    {
+        task_node *node = &graph->nodes[i];
+        cl_command_queue queue = graph->queues[node->queue_index];
+        cl_uint num_waits = 0;
+
+        for(int d = 0 ; d < node->num_deps ; d++)
+        {
+            task_node *dep = &graph->nodes[node->deps[d]];
+            if(graph->out_of_order || dep->queue_index != node->queue_index)
+            {
+                wait_list[num_waits++] = dep->event;
+            }
+        }
+
+        switch(node->type)
+        {
+            case TASK_NODE_KERNEL:
+                for(cl_uint a = 0 ; a < node->num_args && err == CL_SUCCESS ; a++)
+                {
+                    err = clSetKernelArg(node->kernel , a , node->arg_sizes[a] , node->arg_values[a]);
+                }
+                if(err == CL_SUCCESS)
+                {
+                    err = clEnqueueNDRangeKernel(queue , node->kernel , node->work_dim , NULL , node->global_size ,
+                                                 node->has_local_size ? node->local_size : NULL ,
+                                                 num_waits , num_waits ? wait_list : NULL , &node->event);
+                }
+                break;
+
+            case TASK_NODE_WRITE:
+                err = clEnqueueWriteBuffer(queue , node->dst , CL_FALSE , node->dst_offset , node->size , node->host_ptr ,
+                                           num_waits , num_waits ? wait_list : NULL , &node->event);
+                break;
+
+            case TASK_NODE_READ:
+                err = clEnqueueReadBuffer(queue , node->src , CL_FALSE , node->src_offset , node->size , node->host_ptr ,
+                                          num_waits , num_waits ? wait_list : NULL , &node->event);
+                break;
+
+            case TASK_NODE_COPY:
+                err = clEnqueueCopyBuffer(queue , node->src , node->dst , node->src_offset , node->dst_offset , node->size ,
+                                          num_waits , num_waits ? wait_list : NULL , &node->event);
+                break;
+        }
+    }
+
+    free(wait_list);
+
+    for(int q = 0 ; q < graph->num_queues ; q++)
+    {
+        clFlush(graph->queues[q]);
+    }
+
+    return err;
+}
+
+cl_int task_graph_wait(task_graph *graph)
+{
+    cl_int err = CL_SUCCESS;
+
+    for(int q = 0 ; q < graph->num_queues ; q++)
+    {
+        err |= clFinish(graph->queues[q]);
+    }
+    return err;
+}
+
+cl_event task_graph_event(const task_graph *graph , int node)
+{
+    return graph->nodes[node].event;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void task_graph_release(task_graph *graph)
+{
+    task_graph_wait(graph);
+    release_events(graph);
+
+    for(int i = 0 ; i < graph->num_nodes ; i++)
+    {
+        for(cl_uint a = 0 ; a < graph->nodes[i].num_args ; a++)
+        {
+            free(graph->nodes[i].arg_values[a]);
+        }
+        free(graph->nodes[i].uses);
+        free(graph->nodes[i].deps);
+    }
+    free(graph->nodes);
+
+    for(int q = 0 ; q < graph->num_queues ; q++)
+    {
+        clReleaseCommandQueue(graph->queues[q]);
+    }
+
+    memset(graph , 0 , sizeof(*graph));
+}
@@ -0,0 +1,135 @@
+/*
+
+Task Graph Executor
+-------------------
+
+1. A task graph is a list of nodes: kernel launches , host to device writes , device to host reads and device copies.
+2. Every node declares the memory it touches: the cl_mem buffers a kernel reads or writes, and the host pointers a transfer uses.
+   Dependencies follow from those declarations in insertion order:
+       read after write , write after read and write after write on the same buffer or host pointer.
+3. Independent nodes get no edge between them, so the device is free to run them concurrently.
+4. If the device supports CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE , every node goes to one out-of-order queue and the ordering comes
+   only from cl_event wait lists. Otherwise the graph spreads nodes over TASK_GRAPH_NUM_QUEUES in-order queues, keeping chains on one queue.
+5. Transfers are never blocking. task_graph_run submits the whole graph and returns, task_graph_wait blocks until it has finished.
+6. The graph is reusable: kernel arguments are copied when a node is added and applied again on each run, so the same graph can be
+   submitted every iteration. task_graph_set_arg changes a scalar argument between runs.
+
+*/
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <stddef.h>
+
+#ifdef MAC
+#include <OpenCL/cl.h>
+#else
+#ifndef CL_TARGET_OPENCL_VERSION
+#define CL_TARGET_OPENCL_VERSION 300
+#endif
+#include <CL/cl.h>
+#endif
+
+#define TASK_GRAPH_NUM_QUEUES 4
+#define TASK_GRAPH_MAX_ARGS 16
+
+typedef enum
+{
+    TASK_ACCESS_NONE = 0,       // scalar argument
+    TASK_ACCESS_READ = 1,
+    TASK_ACCESS_WRITE = 2,
+    TASK_ACCESS_READ_WRITE = 3
+} task_access;
+
+typedef struct
+{
+    size_t size;
+    const void *value;
+    task_access access;         // for cl_mem arguments , how the kernel uses the buffer
+} task_arg;
+
+#define TASK_ARG_MEM(buffer , access) ((task_arg){sizeof(cl_mem) , &(buffer) , (access)})
+#define TASK_ARG_VALUE(variable) ((task_arg){sizeof(variable) , &(variable) , TASK_ACCESS_NONE})
+
+typedef enum
+{
+    TASK_NODE_KERNEL,
+    TASK_NODE_WRITE,
+    TASK_NODE_READ,
+    TASK_NODE_COPY
+} task_node_type;
+
+typedef struct
+{
+    const void *resource;       // cl_mem or host pointer
+    task_access access;
+} task_use;
+
+typedef struct
+{
+    task_node_type type;
+
+    cl_kernel kernel;
+    cl_uint work_dim;
+    size_t global_size[3];
+    size_t local_size[3];
+    int has_local_size;
+    cl_uint num_args;
+    size_t arg_sizes[TASK_GRAPH_MAX_ARGS];
+    task_access arg_access[TASK_GRAPH_MAX_ARGS];
+    unsigned char *arg_values[TASK_GRAPH_MAX_ARGS];
+
+    cl_mem src;
+    cl_mem dst;
+    void *host_ptr;
+    size_t src_offset;
+    size_t dst_offset;
+    size_t size;
+
+    task_use *uses;
+    int num_uses;
+    int *deps;
+    int num_deps;
+
+    int queue_index;
+    cl_event event;
+} task_node;
+
+typedef struct
+{
+    cl_context context;
+    cl_device_id device;
+    cl_command_queue queues[TASK_GRAPH_NUM_QUEUES];
+    int num_queues;
+    int out_of_order;
+
+    task_node *nodes;
+    int num_nodes;
+    int capacity;
+} task_graph;
+
+// Creates the queues. extra_properties (e.g. CL_QUEUE_PROFILING_ENABLE) are OR'ed into every queue.
+cl_int task_graph_init(task_graph *graph , cl_context context , cl_device_id device , cl_command_queue_properties extra_properties);
+
+// Each add function returns the node index. task_graph_add_kernel returns -1 and adds nothing when work_dim is not 1 , 2 or 3 ,
+// when num_args is above TASK_GRAPH_MAX_ARGS , or when an argument with an access other than TASK_ACCESS_NONE has a NULL value
+// or a size other than sizeof(cl_mem).
+int task_graph_add_kernel(task_graph *graph , cl_kernel kernel , cl_uint work_dim , const size_t *global_size , const size_t *local_size ,
+                          cl_uint num_args , const task_arg *args);
+int task_graph_add_write(task_graph *graph , cl_mem buffer , size_t offset , size_t size , const void *host_ptr);
+int task_graph_add_read(task_graph *graph , cl_mem buffer , size_t offset , size_t size , void *host_ptr);
+int task_graph_add_copy(task_graph *graph , cl_mem src , cl_mem dst , size_t src_offset , size_t dst_offset , size_t size);
+
+// Replaces a kernel argument of a node for the following runs. Dependencies are not recomputed , so an argument added with an
+// access other than TASK_ACCESS_NONE cannot be replaced (CL_INVALID_ARG_VALUE). CL_INVALID_VALUE for a node that is not a kernel.
+cl_int task_graph_set_arg(task_graph *graph , int node , cl_uint arg_index , size_t size , const void *value);
+
+cl_int task_graph_run(task_graph *graph);
+cl_int task_graph_wait(task_graph *graph);
+
+// Event of a node from the last run , valid until the next run. Useful for profiling.
+cl_event task_graph_event(const task_graph *graph , int node);
+
+void task_graph_release(task_graph *graph);
+
+#endif
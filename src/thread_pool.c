@@ -0,0 +1,240 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    size_t head;    // next chunk the owner takes
+    size_t tail;    // one past the last chunk , thieves take tail - 1
+} work_deque;
+
+struct thread_pool
+{
+    int num_threads;
+    pthread_t *threads;
+    work_deque *deques;
+
+    pthread_mutex_t job_lock;       // serializes parallel_for calls
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+    unsigned long generation;
+    int active;
+    int shutdown;
+
+    range_func func;
+    void *arg;
+    size_t count;
+    size_t grain;
+};
+
+typedef struct
+{
+    thread_pool *pool;
+    int index;
+} worker_arg;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static int take_chunk(work_deque *deque , int steal , size_t *chunk)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&deque->lock);
+    if(deque->head < deque->tail)
+    {
+        *chunk = steal ? --deque->tail : deque->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void run_chunks(thread_pool *pool , int index)
+{
+    size_t chunk;
+
+    for(;;)
+    {
+        int found = take_chunk(&pool->deques[index] , 0 , &chunk);
+
+        for(int i = 1 ; !found && i < pool->num_threads ; i++)
+        {
+            found = take_chunk(&pool->deques[(index + i) % pool->num_threads] , 1 , &chunk);
+        }
+
+        // No work is added while a loop runs, so empty deques mean this thread is done
+        if(!found)
+        {
+            return;
+        }
+
+        size_t begin = chunk * pool->grain;
+        size_t end = begin + pool->grain < pool->count ? begin + pool->grain : pool->count;
+        pool->func(begin , end , pool->arg);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void* worker_main(void *data)
+{
+    worker_arg *worker = (worker_arg*)data;
+    thread_pool *pool = worker->pool;
+    int index = worker->index;
+    unsigned long seen = 0;
+
+    free(worker);
+
+    for(;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while(!pool->shutdown && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->start_cond , &pool->lock);
+        }
+        if(pool->shutdown)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool , index);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->active == 0)
+        {
+            pthread_cond_signal(&pool->done_cond);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+thread_pool* thread_pool_create(int num_threads)
+{
+    thread_pool *pool;
+
+    if(num_threads <= 0)
+    {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if(num_threads <= 0)
+        {
+            num_threads = 1;
+        }
+    }
+
+    pool = (thread_pool*)calloc(1 , sizeof(thread_pool));
+    pool->num_threads = num_threads;
+    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * num_threads);
+    pool->deques = (work_deque*)calloc(num_threads , sizeof(work_deque));
+
+    pthread_mutex_init(&pool->job_lock , NULL);
+    pthread_mutex_init(&pool->lock , NULL);
+    pthread_cond_init(&pool->start_cond , NULL);
+    pthread_cond_init(&pool->done_cond , NULL);
+
+    for(int i = 0 ; i < num_threads ; i++)
+    {
+        pthread_mutex_init(&pool->deques[i].lock , NULL);
+    }
+
+    // Thread 0 is the caller of thread_pool_parallel_for
+    for(int i = 1 ; i < num_threads ; i++)
+    {
+        worker_arg *worker = (worker_arg*)malloc(sizeof(worker_arg));
+        worker->pool = pool;
+        worker->index = i;
+        pthread_create(&pool->threads[i] , NULL , worker_main , worker);
+    }
+
+    return pool;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int thread_pool_size(const thread_pool *pool)
+{
+    return pool->num_threads;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void thread_pool_parallel_for(thread_pool *pool , size_t count , size_t grain , range_func func , void *arg)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    if(grain == 0)
+    {
+        grain = 1;
+    }
+
+    size_t num_chunks = (count + grain - 1) / grain;
+    if(pool->num_threads == 1 || num_chunks == 1)
+    {
+        func(0 , count , arg);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->job_lock);
+
+    // Workers are idle here, the previous loop waited for all of them
+    for(int i = 0 ; i < pool->num_threads ; i++)
+    {
+        pool->deques[i].head = num_chunks * i / pool->num_threads;
+        pool->deques[i].tail = num_chunks * (i + 1) / pool->num_threads;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->arg = arg;
+    pool->count = count;
+    pool->grain = grain;
+    pool->active = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool , 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->active > 0)
+    {
+        pthread_cond_wait(&pool->done_cond , &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->job_lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void thread_pool_destroy(thread_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 1 ; i < pool->num_threads ; i++)
+    {
+        pthread_join(pool->threads[i] , NULL);
+    }
+
+    for(int i = 0 ; i < pool->num_threads ; i++)
+    {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_mutex_destroy(&pool->job_lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_cond_destroy(&pool->done_cond);
+
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
@@ -0,0 +1,33 @@
+/*
+
+Work-Stealing Thread Pool
+-------------------------
+
+1. thread_pool_parallel_for splits [0 , count) into chunks of grain items and calls func(begin , end , arg) once per chunk.
+2. The chunks are dealt out evenly, one contiguous run per thread. Each thread takes chunks from the front of its own run.
+3. A thread whose run is empty steals single chunks from the back of the other runs, so uneven chunks (image borders,
+   a busy core) don't leave threads idle.
+4. The calling thread takes part in the loop, and thread_pool_parallel_for returns only after every chunk has finished.
+5. Calls from several threads are serialized. func must not call thread_pool_parallel_for on the same pool.
+
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+typedef struct thread_pool thread_pool;
+
+typedef void (*range_func)(size_t begin , size_t end , void *arg);
+
+// num_threads counts the calling thread. 0 uses one thread per online core.
+thread_pool* thread_pool_create(int num_threads);
+
+int thread_pool_size(const thread_pool *pool);
+
+void thread_pool_parallel_for(thread_pool *pool , size_t count , size_t grain , range_func func , void *arg);
+
+void thread_pool_destroy(thread_pool *pool);
+
+#endif
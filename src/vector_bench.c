@@ -0,0 +1,161 @@
+/*
+
+Vector Width Benchmark
+----------------------
+
+1. Times add_arrays from kernel_compute.cl (one float per work-item) and every variant of the elementwise kernel from vector_ops.cl:
+   widths 1 , 2 , 4 , 8 , 16 with 1 , 4 , 8 and 16 vectors per work-item.
+2. Kernel times come from event profiling , so only device time is compared. Bandwidth counts two reads and one write per element.
+3. The array length is not a multiple of 16 , so every variant runs its scalar tail. Each result must equal a + b exactly.
+4. The row marked with * is what vector_width_auto picks for this device. It should be at or near the fastest row.
+
+Build:
+    gcc vector_bench.c vector_ops.c bench_common.c kernel_cache.c -o vector_bench -lOpenCL
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "vector_ops.h"
+
+#define ARRAY_SIZE ((1 << 24) + 3)
+#define NUM_ITERATIONS 10
+
+static const int widths[] = {1 , 2 , 4 , 8 , 16};
+static const int items[] = {1 , 4 , 8 , 16};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double bandwidth_gbs(double ms)
+{
+    return 3.0 * ARRAY_SIZE * sizeof(float) / (ms * 1.0e6);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static double time_scalar(kernel_cache *cache , cl_command_queue queue , cl_mem a , cl_mem b , cl_mem c)
+{
+    cl_kernel kernel = kernel_cache_get(cache , "kernel_compute.cl" , "add_arrays" , NULL);
+    size_t global_size = ARRAY_SIZE;
+    cl_event event;
+    double total = 0.0;
+
+    clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &a);
+    clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &b);
+    clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &c);
+
+    clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , NULL);
+    clFinish(queue);
+
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        if(clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , &event) != CL_SUCCESS)
+        {
+            printf("Couldn't enqueue add_arrays\n");
+            exit(1);
+        }
+        total += bench_event_ms(event);
+    }
+
+    return total / NUM_ITERATIONS;
+}
+
+static double time_vector(kernel_cache *cache , cl_command_queue queue , cl_mem a , cl_mem b , cl_mem c , int width , int per_item)
+{
+    cl_event event;
+    double total = 0.0;
+
+    // Warm-up launch builds the variant
+    launch_elementwise(cache , queue , ELEMENTWISE_ADD , a , b , c , ARRAY_SIZE , width , per_item , NULL);
+    clFinish(queue);
+
+    for(int i = 0 ; i < NUM_ITERATIONS ; i++)
+    {
+        if(launch_elementwise(cache , queue , ELEMENTWISE_ADD , a , b , c , ARRAY_SIZE , width , per_item , &event) != CL_SUCCESS)
+        {
+            printf("Couldn't enqueue elementwise\n");
+            exit(1);
+        }
+        total += bench_event_ms(event);
+    }
+
+    return total / NUM_ITERATIONS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main()
+{
+    bench_context bench;
+    cl_int err;
+    vector_device_info info;
+    int auto_width , auto_items;
+    char name_data[128];
+
+    bench_init(&bench , 1);
+
+    clGetDeviceInfo(bench.device , CL_DEVICE_NAME , sizeof(name_data) , name_data , NULL);
+    vector_query_device(bench.device , &info);
+    vector_width_auto(&info , &auto_width , &auto_items);
+    printf("%s: preferred float width %u , native float width %u , auto choice float%d x %d per work-item\n\n",
+           name_data , info.preferred_width , info.native_width , auto_width , auto_items);
+
+    size_t bytes = (size_t)ARRAY_SIZE * sizeof(float);
+    float *a = (float*)malloc(bytes);
+    float *b = (float*)malloc(bytes);
+    float *expected = (float*)malloc(bytes);
+    float *result = (float*)malloc(bytes);
+    for(int i = 0 ; i < ARRAY_SIZE ; i++)
+    {
+        a[i] = (float)(i % 1021) * 0.5f;
+        b[i] = (float)(i % 509) * 0.25f;
+        expected[i] = a[i] + b[i];
+    }
+
+    cl_mem a_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , a , &err);
+    cl_mem b_buff = clCreateBuffer(bench.context , CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR , bytes , b , &err);
+    cl_mem c_buff = clCreateBuffer(bench.context , CL_MEM_WRITE_ONLY , bytes , NULL , &err);
+    if(err < 0)
+    {
+        perror("Couldn't create the buffers");
+        exit(1);
+    }
+
+    printf("%-22s %10s %10s\n", "kernel" , "ms" , "GB/s");
+
+    double scalar_ms = time_scalar(&bench.cache , bench.queue , a_buff , b_buff , c_buff);
+    clEnqueueReadBuffer(bench.queue , c_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+    printf("%-22s %10.3f %10.2f %s\n", "add_arrays" , scalar_ms , bandwidth_gbs(scalar_ms) ,
+           memcmp(expected , result , bytes) == 0 ? "" : "MISMATCH");
+
+    for(size_t w = 0 ; w < sizeof(widths) / sizeof(widths[0]) ; w++)
+    {
+        for(size_t it = 0 ; it < sizeof(items) / sizeof(items[0]) ; it++)
+        {
+            char label[32];
+
+            // Clear the output so a variant that skips elements can't pass on a previous result
+            memset(result , 0 , bytes);
+            clEnqueueWriteBuffer(bench.queue , c_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+
+            double ms = time_vector(&bench.cache , bench.queue , a_buff , b_buff , c_buff , widths[w] , items[it]);
+            clEnqueueReadBuffer(bench.queue , c_buff , CL_TRUE , 0 , bytes , result , 0 , NULL , NULL);
+
+            snprintf(label , sizeof(label) , "float%d x %d", widths[w] , items[it]);
+            printf("%-22s %10.3f %10.2f %s%s\n", label , ms , bandwidth_gbs(ms) ,
+                   (widths[w] == auto_width && items[it] == auto_items) ? "* " : "" ,
+                   memcmp(expected , result , bytes) == 0 ? "" : "MISMATCH");
+        }
+    }
+
+    free(a);
+    free(b);
+    free(expected);
+    free(result);
+    clReleaseMemObject(a_buff);
+    clReleaseMemObject(b_buff);
+    clReleaseMemObject(c_buff);
+    bench_release(&bench);
+
+    return 0;
+}
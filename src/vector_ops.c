@@ -0,0 +1,88 @@
+#include <stdio.h>
+
+#include "vector_ops.h"
+
+static const char *op_names[] = {"OP_ADD" , "OP_MULT" , "OP_SUB"};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void vector_query_device(cl_device_id device , vector_device_info *info)
+{
+    info->preferred_width = 0;
+    info->native_width = 0;
+    info->type = CL_DEVICE_TYPE_DEFAULT;
+
+    clGetDeviceInfo(device , CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &info->preferred_width , NULL);
+    clGetDeviceInfo(device , CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT , sizeof(cl_uint) , &info->native_width , NULL);
+    clGetDeviceInfo(device , CL_DEVICE_TYPE , sizeof(cl_device_type) , &info->type , NULL);
+}
+
+void vector_width_auto(const vector_device_info *info , int *width , int *items_per_work_item)
+{
+    cl_uint reported = info->preferred_width ? info->preferred_width : info->native_width;
+    int w = 1;
+
+    // Largest supported vector width that does not exceed the reported one
+    while(w * 2 <= (int)reported && w * 2 <= VECTOR_MAX_WIDTH)
+    {
+        w *= 2;
+    }
+
+    *width = w;
+    *items_per_work_item = (info->type & CL_DEVICE_TYPE_CPU) ? VECTOR_ITEMS_CPU : VECTOR_ITEMS_GPU;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+cl_kernel elementwise_kernel(kernel_cache *cache , elementwise_op op , int *width , int *items_per_work_item)
+{
+    char options[64];
+
+    if(*width <= 0 || *items_per_work_item <= 0)
+    {
+        vector_device_info info = {cache->preferred_float_width , cache->native_float_width , cache->device_type};
+        int auto_width , auto_items;
+
+        vector_width_auto(&info , &auto_width , &auto_items);
+        *width = *width > 0 ? *width : auto_width;
+        *items_per_work_item = *items_per_work_item > 0 ? *items_per_work_item : auto_items;
+    }
+
+    snprintf(options , sizeof(options) , "-DVEC_WIDTH=%d -DITEMS_PER_WI=%d -D%s", *width , *items_per_work_item , op_names[op]);
+    return kernel_cache_get(cache , VECTOR_OPS_PROGRAM , "elementwise" , options);
+}
+
+cl_int enqueue_elementwise(cl_command_queue queue , cl_kernel kernel , cl_mem a , cl_mem b , cl_mem result ,
+                           int n , int width , int items_per_work_item , cl_event *event)
+{
+    cl_int err;
+
+    err  = clSetKernelArg(kernel , 0 , sizeof(cl_mem) , &a);
+    err |= clSetKernelArg(kernel , 1 , sizeof(cl_mem) , &b);
+    err |= clSetKernelArg(kernel , 2 , sizeof(cl_mem) , &result);
+    err |= clSetKernelArg(kernel , 3 , sizeof(int) , &n);
+    if(err != CL_SUCCESS)
+    {
+        return err;
+    }
+
+    // Enough work-items for every vector , and at least one per tail element
+    size_t num_vectors = n / width;
+    size_t global_size = (num_vectors + items_per_work_item - 1) / items_per_work_item;
+    size_t tail = n % width;
+    if(global_size < tail)
+    {
+        global_size = tail;
+    }
+    if(global_size == 0)
+    {
+        return clEnqueueMarkerWithWaitList(queue , 0 , NULL , event);
+    }
+
+    return clEnqueueNDRangeKernel(queue , kernel , 1 , NULL , &global_size , NULL , 0 , NULL , event);
+}
+
+cl_int launch_elementwise(kernel_cache *cache , cl_command_queue queue , elementwise_op op , cl_mem a , cl_mem b , cl_mem result ,
+                          int n , int width , int items_per_work_item , cl_event *event)
+{
+    cl_kernel kernel = elementwise_kernel(cache , op , &width , &items_per_work_item);
+    return enqueue_elementwise(queue , kernel , a , b , result , n , width , items_per_work_item , event);
+}
@@ -0,0 +1,66 @@
+/*
+    Vectorized elementwise kernels. The macros below are supplied as -D build options by launch_elementwise (vector_ops.c).
+
+    VEC_WIDTH       floats per vector: 1 , 2 , 4 , 8 or 16 (default 4)
+    ITEMS_PER_WI    vectors processed by each work-item (default 1)
+    OP_ADD , OP_MULT , OP_SUB
+                    the operation , add when none is given
+
+    1. Work-item gid handles the vectors gid , gid + global_size , gid + 2 * global_size ... so neighbouring work-items
+       always touch neighbouring vectors (coalesced on GPUs , and what CPU implementations vectorize across).
+    2. The last n % VEC_WIDTH elements do not fill a vector. They are handled as scalars by the first work-items.
+*/
+
+#ifndef VEC_WIDTH
+#define VEC_WIDTH 4
+#endif
+
+#ifndef ITEMS_PER_WI
+#define ITEMS_PER_WI 1
+#endif
+
+#define CAT(a , b) a##b
+#define XCAT(a , b) CAT(a , b)
+
+#if VEC_WIDTH == 1
+#define VTYPE float
+#define VLOAD(index , p) (p)[index]
+#define VSTORE(v , index , p) (p)[index] = (v)
+#else
+#define VTYPE XCAT(float , VEC_WIDTH)
+#define VLOAD(index , p) XCAT(vload , VEC_WIDTH)(index , p)
+#define VSTORE(v , index , p) XCAT(vstore , VEC_WIDTH)(v , index , p)
+#endif
+
+#if defined(OP_MULT)
+#define APPLY(x , y) ((x) * (y))
+#elif defined(OP_SUB)
+#define APPLY(x , y) ((x) - (y))
+#else
+#define APPLY(x , y) ((x) + (y))
+#endif
+
+__kernel void elementwise(__global const float *a , __global const float *b , __global float *result , int n)
+{
+    int gid = get_global_id(0);
+    int stride = get_global_size(0);
+    int num_vectors = n / VEC_WIDTH;
+
+    for(int item = 0 ; item < ITEMS_PER_WI ; item++)
+    {
+        int v = gid + item * stride;
+        if(v < num_vectors)
+        {
+            VTYPE x = VLOAD(v , a);
+            VTYPE y = VLOAD(v , b);
+            VSTORE(APPLY(x , y) , v , result);
+        }
+    }
+
+    // Scalar tail
+    int tail = num_vectors * VEC_WIDTH + gid;
+    if(tail < n)
+    {
+        result[tail] = APPLY(a[tail] , b[tail]);
+    }
+}
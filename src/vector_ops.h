@@ -0,0 +1,59 @@
+/*
+
+Vector Width Aware Elementwise Kernels
+--------------------------------------
+
+1. add_arrays (kernel_compute.cl) , add_kernel (good.cl) and mult / add / sub (kernel_search.cl) handle one float per work-item.
+   On CPU devices that leaves SIMD lanes idle , and scheduling the work-items costs more than the arithmetic.
+2. launch_elementwise runs the same operations from vector_ops.cl with floatN loads and stores (N = 1 , 2 , 4 , 8 , 16)
+   and several vectors per work-item. Each (width , items , op) combination is a kernel variant in the kernel cache.
+3. vector_width_auto picks the width from CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , or CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT
+   when the preferred width is not reported. CPU devices also get VECTOR_ITEMS_CPU vectors per work-item , GPUs get
+   VECTOR_ITEMS_GPU so there are enough work-items to fill the device. launch_elementwise takes these properties from the
+   kernel_cache , which reads them once , so the automatic choice costs no clGetDeviceInfo call per launch.
+4. vector_bench.c measures every width against the automatic choice.
+5. launch_elementwise is elementwise_kernel (variant lookup , which may build) followed by enqueue_elementwise.
+
+*/
+
+#ifndef VECTOR_OPS_H
+#define VECTOR_OPS_H
+
+#include "kernel_cache.h"
+
+#define VECTOR_OPS_PROGRAM "vector_ops.cl"
+#define VECTOR_MAX_WIDTH 16
+#define VECTOR_ITEMS_CPU 8
+#define VECTOR_ITEMS_GPU 1
+
+typedef enum
+{
+    ELEMENTWISE_ADD,
+    ELEMENTWISE_MULT,
+    ELEMENTWISE_SUB
+} elementwise_op;
+
+typedef struct
+{
+    cl_uint preferred_width;
+    cl_uint native_width;
+    cl_device_type type;
+} vector_device_info;
+
+void vector_query_device(cl_device_id device , vector_device_info *info);
+
+// Width and vectors per work-item used when launch_elementwise is given 0 for them
+void vector_width_auto(const vector_device_info *info , int *width , int *items_per_work_item);
+
+// Resolves width / items_per_work_item of 0 with vector_width_auto and returns the matching variant from the cache
+cl_kernel elementwise_kernel(kernel_cache *cache , elementwise_op op , int *width , int *items_per_work_item);
+
+// Sets the arguments of a kernel from elementwise_kernel and enqueues it with the width it was built for
+cl_int enqueue_elementwise(cl_command_queue queue , cl_kernel kernel , cl_mem a , cl_mem b , cl_mem result ,
+                           int n , int width , int items_per_work_item , cl_event *event);
+
+// result[i] = a[i] op b[i] for n floats. width / items_per_work_item of 0 use vector_width_auto.
+cl_int launch_elementwise(kernel_cache *cache , cl_command_queue queue , elementwise_op op , cl_mem a , cl_mem b , cl_mem result ,
+                          int n , int width , int items_per_work_item , cl_event *event);
+
+#endif
@@ -0,0 +1,333 @@
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "verify.h"
+
+#define COMPARE_GRAIN 65536
+#define BLOCK_ROWS 32
+#define BLOCK_COLS 256
+#define BLOCK_INNER 256
+
+//----------------------------------------------------------------------------------------------------------------------------------
+unsigned long long verify_ulp_distance(float a , float b)
+{
+    int32_t ia , ib;
+
+    if(isnan(a) || isnan(b))
+    {
+        return ULLONG_MAX;
+    }
+
+    // Map the sign-magnitude bit patterns onto a monotonic integer line , so -0.0f and +0.0f are both 0
+    memcpy(&ia , &a , sizeof(ia));
+    memcpy(&ib , &b , sizeof(ib));
+    int64_t oa = ia < 0 ? (int64_t)INT32_MIN - ia : ia;
+    int64_t ob = ib < 0 ? (int64_t)INT32_MIN - ib : ib;
+
+    return oa > ob ? (unsigned long long)(oa - ob) : (unsigned long long)(ob - oa);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+static void report_init(verify_report *report , size_t total)
+{
+    memset(report , 0 , sizeof(*report));
+    report->total = total;
+}
+
+static void check_element(verify_report *report , size_t index , double expected , float actual , const verify_tolerance *tolerance)
+{
+    double abs_error = fabs(expected - actual);
+    double rel_error = expected != 0.0 ? abs_error / fabs(expected) : abs_error;
+    unsigned long long ulp_error = verify_ulp_distance((float)expected , actual);
+
+    if(isnan(actual) != isnan(expected))
+    {
+        abs_error = rel_error = INFINITY;
+    }
+
+    report->checked++;
+
+    if(!(abs_error <= tolerance->abs_tol || rel_error <= tolerance->rel_tol || ulp_error <= tolerance->max_ulp))
+    {
+        report->failures++;
+    }
+
+    if(abs_error > report->max_abs_error || report->checked == 1)
+    {
+        report->max_abs_error = abs_error;
+        report->worst_index = index;
+        report->worst_expected = expected;
+        report->worst_actual = actual;
+    }
+    if(rel_error > report->max_rel_error)
+    {
+        report->max_rel_error = rel_error;
+    }
+    if(ulp_error > report->max_ulp_error)
+    {
+        report->max_ulp_error = ulp_error;
+    }
+}
+
+static void report_merge(verify_report *into , const verify_report *part)
+{
+    if(part->checked == 0)
+    {
+        return;
+    }
+
+    if(into->checked == 0 || part->max_abs_error > into->max_abs_error)
+    {
+        into->max_abs_error = part->max_abs_error;
+        into->worst_index = part->worst_index;
+        into->worst_expected = part->worst_expected;
+        into->worst_actual = part->worst_actual;
+    }
+    if(part->max_rel_error > into->max_rel_error)
+    {
+        into->max_rel_error = part->max_rel_error;
+    }
+    if(part->max_ulp_error > into->max_ulp_error)
+    {
+        into->max_ulp_error = part->max_ulp_error;
+    }
+    into->checked += part->checked;
+    into->failures += part->failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const float *expected;
+    reference_func reference;
+    void *arg;
+    const float *actual;
+    const size_t *indices;      // NULL checks every element
+    verify_tolerance tolerance;
+    pthread_mutex_t lock;
+    verify_report *report;
+} compare_task;
+
+static void compare_range(size_t begin , size_t end , void *data)
+{
+    compare_task *task = (compare_task*)data;
+    verify_report part;
+
+    report_init(&part , 0);
+    for(size_t i = begin ; i < end ; i++)
+    {
+        size_t index = task->indices ? task->indices[i] : i;
+        double expected = task->expected ? task->expected[index] : task->reference(index , task->arg);
+        check_element(&part , index , expected , task->actual[index] , &task->tolerance);
+    }
+
+    pthread_mutex_lock(&task->lock);
+    report_merge(task->report , &part);
+    pthread_mutex_unlock(&task->lock);
+}
+
+static void run_compare(thread_pool *pool , compare_task *task , size_t count , size_t grain)
+{
+    pthread_mutex_init(&task->lock , NULL);
+    if(pool != NULL)
+    {
+        thread_pool_parallel_for(pool , count , grain , compare_range , task);
+    }
+    else
+    {
+        compare_range(0 , count , task);
+    }
+    pthread_mutex_destroy(&task->lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int verify_compare(thread_pool *pool , const float *expected , const float *actual , size_t n ,
+                   verify_tolerance tolerance , verify_report *report)
+{
+    compare_task task = {.expected = expected , .actual = actual , .tolerance = tolerance , .report = report};
+
+    report_init(report , n);
+    run_compare(pool , &task , n , COMPARE_GRAIN);
+
+    return report->failures == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int verify_against_reference(thread_pool *pool , reference_func reference , void *arg , const float *actual , size_t n ,
+                             verify_tolerance tolerance , verify_report *report)
+{
+    compare_task task = {.reference = reference , .arg = arg , .actual = actual , .tolerance = tolerance , .report = report};
+    size_t *indices = NULL;
+    size_t count = n;
+
+    report_init(report , n);
+
+    if(n > tolerance.sample_threshold && tolerance.num_samples < n)
+    {
+        // Always include both ends , they are where indexing mistakes show up first
+        unsigned int state = tolerance.seed ? tolerance.seed : 1;
+        count = tolerance.num_samples < 2 ? 2 : tolerance.num_samples;
+        indices = (size_t*)malloc(sizeof(size_t) * count);
+        indices[0] = 0;
+        indices[1] = n - 1;
+        for(size_t i = 2 ; i < count ; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            size_t high = (size_t)state << 32;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            indices[i] = (high | state) % n;
+        }
+        task.indices = indices;
+    }
+
+    // Each reference element may cost a whole dot product , so use small chunks
+    run_compare(pool , &task , count , 64);
+    free(indices);
+
+    return report->failures == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/*
+    1. Row blocks of BLOCK_ROWS rows are distributed over the pool.
+    2. Inside a block the j and k loops are tiled so a BLOCK_INNER x BLOCK_COLS tile of B stays in cache while every row of the block uses it.
+    3. The innermost loop runs along a row of B and of the accumulator , which the compiler vectorizes.
+*/
+typedef struct
+{
+    const float *A;
+    const float *B;
+    double *C;
+    size_t m;
+    size_t n;
+    size_t k;
+} matmul_task;
+
+static void matmul_rows(size_t begin , size_t end , void *data)
+{
+    matmul_task *task = (matmul_task*)data;
+    size_t n = task->n;
+    size_t k = task->k;
+
+    for(size_t i0 = begin * BLOCK_ROWS ; i0 < end * BLOCK_ROWS && i0 < task->m ; i0 += BLOCK_ROWS)
+    {
+        size_t i1 = i0 + BLOCK_ROWS < task->m ? i0 + BLOCK_ROWS : task->m;
+
+        for(size_t i = i0 ; i < i1 ; i++)
+        {
+            memset(task->C + i * n , 0 , sizeof(double) * n);
+        }
+
+        for(size_t j0 = 0 ; j0 < n ; j0 += BLOCK_COLS)
+        {
+            size_t j1 = j0 + BLOCK_COLS < n ? j0 + BLOCK_COLS : n;
+            for(size_t x0 = 0 ; x0 < k ; x0 += BLOCK_INNER)
+            {
+                size_t x1 = x0 + BLOCK_INNER < k ? x0 + BLOCK_INNER : k;
+                for(size_t i = i0 ; i < i1 ; i++)
+                {
+                    double *c = task->C + i * n;
+                    for(size_t x = x0 ; x < x1 ; x++)
+                    {
+                        double a = task->A[i * k + x];
+                        const float *b = task->B + x * n;
+                        for(size_t j = j0 ; j < j1 ; j++)
+                        {
+                            c[j] += a * b[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void verify_reference_matmul(thread_pool *pool , const float *A , const float *B , double *C , size_t m , size_t n , size_t k)
+{
+    matmul_task task = {A , B , C , m , n , k};
+    size_t num_blocks = (m + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+    if(pool != NULL)
+    {
+        thread_pool_parallel_for(pool , num_blocks , 1 , matmul_rows , &task);
+    }
+    else
+    {
+        matmul_rows(0 , num_blocks , &task);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const float *A;
+    const float *B;
+    const double *C;
+    size_t n;
+    size_t k;
+} matmul_reference;
+
+static double matmul_stored(size_t index , void *arg)
+{
+    return ((matmul_reference*)arg)->C[index];
+}
+
+static double matmul_element(size_t index , void *arg)
+{
+    matmul_reference *ref = (matmul_reference*)arg;
+    size_t row = index / ref->n;
+    size_t col = index % ref->n;
+    double sum = 0.0;
+
+    for(size_t x = 0 ; x < ref->k ; x++)
+    {
+        sum += (double)ref->A[row * ref->k + x] * ref->B[x * ref->n + col];
+    }
+    return sum;
+}
+
+int verify_matmul(thread_pool *pool , const float *A , const float *B , const float *C , size_t m , size_t n , size_t k ,
+                  verify_tolerance tolerance , verify_report *report)
+{
+    matmul_reference ref = {A , B , NULL , n , k};
+    int passed;
+
+    if(m * n > tolerance.sample_threshold)
+    {
+        return verify_against_reference(pool , matmul_element , &ref , C , m * n , tolerance , report);
+    }
+
+    double *expected = (double*)malloc(sizeof(double) * m * n);
+    verify_reference_matmul(pool , A , B , expected , m , n , k);
+    ref.C = expected;
+
+    compare_task task = {.reference = matmul_stored , .arg = &ref , .actual = C , .tolerance = tolerance , .report = report};
+    report_init(report , m * n);
+    run_compare(pool , &task , m * n , COMPARE_GRAIN);
+    passed = report->failures == 0;
+
+    free(expected);
+    return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void verify_print(const char *name , const verify_report *report)
+{
+    printf("%s: %s , checked %zu of %zu elements , %zu outside tolerance\n", name , report->failures == 0 ? "PASSED" : "FAILED" ,
+           report->checked , report->total , report->failures);
+    printf("    max abs error %g , max rel error %g , max ulp error %llu\n", report->max_abs_error , report->max_rel_error ,
+           report->max_ulp_error);
+    if(report->checked > 0)
+    {
+        printf("    worst at index %zu : expected %.9g , got %.9g\n", report->worst_index , report->worst_expected , report->worst_actual);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+
+Result Verification
+-------------------
+
+1. Floating point results from a device rarely match a host loop bit for bit: the device may contract a * b + c into an FMA,
+   sum in a different order or flush denormals. Comparing with == reports false failures, so results are compared with tolerances.
+2. An element passes when any of these holds:
+       |expected - actual| <= abs_tol                      (values near zero)
+       |expected - actual| <= rel_tol * |expected|         (relative error)
+       ulp distance(expected , actual) <= max_ulp          (representable floats in between)
+3. Comparisons and references run on a thread_pool. Passing a NULL pool runs them on the calling thread.
+4. When a reference element is expensive (a dot product of length k) and the output has more than sample_threshold elements,
+   only num_samples randomly chosen elements are checked, so verification can stay enabled for production size runs.
+5. The report holds the largest error and where it happened, not only pass / fail.
+
+*/
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stddef.h>
+
+#include "thread_pool.h"
+
+typedef struct
+{
+    float abs_tol;
+    float rel_tol;
+    unsigned int max_ulp;
+    size_t sample_threshold;
+    size_t num_samples;
+    unsigned int seed;
+} verify_tolerance;
+
+#define VERIFY_DEFAULT_TOLERANCE ((verify_tolerance){1e-6f , 1e-5f , 4 , 1 << 24 , 1 << 16 , 12345})
+
+typedef struct
+{
+    size_t checked;           // elements compared
+    size_t total;             // elements in the output
+    size_t failures;          // elements outside every tolerance
+    size_t worst_index;       // element with the largest absolute error
+    double worst_expected;
+    double worst_actual;
+    double max_abs_error;
+    double max_rel_error;
+    unsigned long long max_ulp_error;
+} verify_report;
+
+// Reference value of output element index , for references that are computed on demand
+typedef double (*reference_func)(size_t index , void *arg);
+
+// Distance in units in the last place between two floats. Returns ULLONG_MAX if either is NaN.
+unsigned long long verify_ulp_distance(float a , float b);
+
+// Compares every element of actual against a precomputed expected array
+int verify_compare(thread_pool *pool , const float *expected , const float *actual , size_t n ,
+                   verify_tolerance tolerance , verify_report *report);
+
+// Compares actual against reference(index). Checks every element , or a random sample when n > sample_threshold.
+int verify_against_reference(thread_pool *pool , reference_func reference , void *arg , const float *actual , size_t n ,
+                             verify_tolerance tolerance , verify_report *report);
+
+// C (m x n) = A (m x k) * B (k x n) , row-major , computed with a blocked multithreaded loop in double precision
+void verify_reference_matmul(thread_pool *pool , const float *A , const float *B , double *C , size_t m , size_t n , size_t k);
+
+// Checks C = A * B. Small problems get the full blocked reference , large ones are sampled element by element.
+int verify_matmul(thread_pool *pool , const float *A , const float *B , const float *C , size_t m , size_t n , size_t k ,
+                  verify_tolerance tolerance , verify_report *report);
+
+void verify_print(const char *name , const verify_report *report);
+
+#endif